@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+
+//alignment used for every grid array, one cache line
+constexpr std::size_t gridAlignment = 64;
+
+//Heap array of trivially copyable values whose storage starts on a gridAlignment boundary.
+//Used for the per-field arrays of the forest grid, so each field is one contiguous stream.
+template<typename T>
+class AlignedArray
+{
+public:
+	AlignedArray() = default;
+	explicit AlignedArray(std::size_t count) { resize(count); }
+	~AlignedArray() { release(); }
+
+	AlignedArray(const AlignedArray&) = delete;
+	AlignedArray& operator=(const AlignedArray&) = delete;
+
+	AlignedArray(AlignedArray&& other) noexcept : ptr(other.ptr), count(other.count)
+	{
+		other.ptr = nullptr;
+		other.count = 0;
+	}
+
+	AlignedArray& operator=(AlignedArray&& other) noexcept
+	{
+		std::swap(ptr, other.ptr);
+		std::swap(count, other.count);
+		return *this;
+	}
+
+	//reallocate to hold count zeroed elements
+	void resize(std::size_t newCount)
+	{
+		release();
+		if (newCount == 0) return;
+
+		//round the byte size up to the alignment, required by aligned_alloc
+		std::size_t bytes = (newCount * sizeof(T) + gridAlignment - 1) / gridAlignment * gridAlignment;
+#ifdef _MSC_VER
+		ptr = static_cast<T*>(_aligned_malloc(bytes, gridAlignment));
+#else
+		ptr = static_cast<T*>(std::aligned_alloc(gridAlignment, bytes));
+#endif
+		if (!ptr) throw std::bad_alloc();
+
+		std::memset(ptr, 0, bytes);
+		count = newCount;
+	}
+
+	//set every element to zero
+	void clear()
+	{
+		if (ptr) std::memset(ptr, 0, count * sizeof(T));
+	}
+
+	T* data() { return ptr; }
+	const T* data() const { return ptr; }
+	std::size_t size() const { return count; }
+
+	T& operator[](std::size_t i) { return ptr[i]; }
+	const T& operator[](std::size_t i) const { return ptr[i]; }
+
+private:
+	void release()
+	{
+#ifdef _MSC_VER
+		_aligned_free(ptr);
+#else
+		std::free(ptr);
+#endif
+		ptr = nullptr;
+		count = 0;
+	}
+
+	T* ptr = nullptr;
+	std::size_t count = 0;
+};
@@ -0,0 +1,74 @@
+#include "CounterRandom.h"
+#include "DayKernels.h"
+#include <cmath>
+
+std::uint64_t probabilityThreshold(double probability)
+{
+	if (!(probability > 0))
+		return 0;
+	if (probability >= 1)
+		return ~std::uint64_t(0);
+	return std::uint64_t(std::ldexp(probability, 64));
+}
+
+void CounterRandom::blocks(int trial, int day, int firstPair, int count, RandomPurpose purpose, std::uint64_t* out) const
+{
+	RandomBlocks blocks;
+	blocks.key[0] = std::uint32_t(seedKey);
+	blocks.key[1] = std::uint32_t(seedKey >> 32);
+	blocks.firstPair = std::uint32_t(firstPair);
+	blocks.day = std::uint32_t(day);
+	blocks.trial = std::uint32_t(trial);
+	blocks.purpose = std::uint32_t(purpose);
+	blocks.out = out;
+	blocks.count = count;
+	random_blocks(blocks);
+}
+
+void CounterRandom::laneBlocks(std::uint64_t* out, const std::uint32_t* trials, const std::uint32_t* days, const std::uint32_t* pairs, int count, RandomPurpose purpose) const
+{
+	RandomLaneBlocks blocks;
+	blocks.key[0] = std::uint32_t(seedKey);
+	blocks.key[1] = std::uint32_t(seedKey >> 32);
+	blocks.pairs = pairs;
+	blocks.days = days;
+	blocks.trials = trials;
+	blocks.purpose = std::uint32_t(purpose);
+	blocks.out = out;
+	blocks.count = count;
+	random_lane_blocks(blocks);
+}
+
+std::uint64_t CounterRandom::operator()(int trial, int day, int tile, RandomPurpose purpose) const
+{
+	std::uint64_t values[2];
+	blocks(trial, day, tile / 2, 1, purpose, values);
+	return values[tile % 2];
+}
+
+void CounterRandom::fill(std::uint64_t* out, int trial, int day, int firstTile, int count, RandomPurpose purpose) const
+{
+	int tile = firstTile;
+	int last = firstTile + count;
+	std::uint64_t values[2];
+
+	//odd first tile: second half of a block
+	if (tile < last && tile % 2 != 0)
+	{
+		blocks(trial, day, tile / 2, 1, purpose, values);
+		*out++ = values[1];
+		++tile;
+	}
+
+	//whole blocks straight into out, vectorized by the day kernels
+	int pairs = (last - tile) / 2;
+	blocks(trial, day, tile / 2, pairs, purpose, out);
+	out += 2 * pairs;
+	tile += 2 * pairs;
+
+	if (tile < last)
+	{
+		blocks(trial, day, tile / 2, 1, purpose, values);
+		*out = values[0];
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+
+//Convert a probability to an integer threshold: a uniform raw 64 bit draw r is below probabilityThreshold(p) with probability p.
+//Lets a per tile test like uniform(0, 1) < p run as a single integer compare on the raw draw.
+std::uint64_t probabilityThreshold(double probability);
+
+//What a random value is used for. Part of the value's counter, so every use has its own stream
+enum class RandomPurpose : std::uint32_t
+{
+	LeafIncrement = 0,
+	Ignition = 1,
+	FireDuration = 2,
+	IgnitionSkip = 3,
+	ArrivalDays = 0x100 //plus the index of the arrival, see run_trial_events
+};
+
+//Counter based random number generator (Philox4x32-10). Every raw 64 bit value is a pure function of the seed and its
+//(trial, day, tile, purpose) counter, with no state carried from one value to the next. Any value can be computed on its own,
+//in any order, by any thread or vector lane, and the results stay bit identical however the work is split up.
+//tile is the flat tile index row * width + col.
+class CounterRandom
+{
+public:
+	explicit CounterRandom(std::uint64_t seedValue = 0) { seed(seedValue); }
+
+	void seed(std::uint64_t seedValue) { seedKey = seedValue; }
+
+	//the value of one tile
+	std::uint64_t operator()(int trial, int day, int tile, RandomPurpose purpose) const;
+
+	//the values of tiles [firstTile, firstTile + count) to out, the same values operator() gives one at a time
+	void fill(std::uint64_t* out, int trial, int day, int firstTile, int count, RandomPurpose purpose) const;
+
+	//Philox blocks of many trials and days at once (see TrialLanes): block k is pair pairs[k] of trial trials[k] on day days[k],
+	//so out[2 * k] and out[2 * k + 1] get the values of its tiles 2 * pairs[k] and 2 * pairs[k] + 1
+	void laneBlocks(std::uint64_t* out, const std::uint32_t* trials, const std::uint32_t* days, const std::uint32_t* pairs, int count, RandomPurpose purpose) const;
+
+private:
+	//Philox blocks [firstPair, firstPair + count) to out, two values each. Block pair gives the values of tiles 2 * pair and 2 * pair + 1
+	void blocks(int trial, int day, int firstPair, int count, RandomPurpose purpose, std::uint64_t* out) const;
+
+	std::uint64_t seedKey;
+};
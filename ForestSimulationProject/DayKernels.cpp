@@ -0,0 +1,140 @@
+//Scalar build of the day kernels, and the startup pick of the best variant for this CPU
+#include "DayKernels.h"
+#include <cstring>
+
+#ifdef DAY_KERNELS_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace
+{
+
+#include "DayKernels.inl"
+
+LeafTotalsDelta scalarLeafMorningRow(const LeafMorningRow& row, const LeafMorningParams& params)
+{
+	return leafMorningRowScalar(row, params, 0);
+}
+
+void scalarRandomBlocks(const RandomBlocks& blocks)
+{
+	randomBlocksScalar(blocks, 0);
+}
+
+void scalarRandomLaneBlocks(const RandomLaneBlocks& blocks)
+{
+	randomLaneBlocksScalar(blocks, 0);
+}
+
+#ifdef DAY_KERNELS_X86
+
+//registers eax, ebx, ecx, edx of a cpuid leaf
+void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+{
+#ifdef _MSC_VER
+	int r[4];
+	__cpuidex(r, int(leaf), int(subleaf));
+	for (int k = 0; k < 4; ++k) regs[k] = unsigned(r[k]);
+#else
+	if (!__get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3]))
+		regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#endif
+}
+
+//register state the OS saves on context switches, XCR0
+std::uint64_t osSavedState()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (std::uint64_t(edx) << 32) | eax;
+#endif
+}
+
+bool cpuSupports(const DayKernelTable& kernels)
+{
+	if (&kernels == &scalarDayKernels)
+		return true;
+
+	unsigned int regs[4];
+	cpuid(0, 0, regs);
+	unsigned int maxLeaf = regs[0];
+
+	cpuid(1, 0, regs);
+	bool sse2 = (regs[3] >> 26) & 1;
+	bool osxsave = (regs[2] >> 27) & 1;
+	if (&kernels == &sse2DayKernels)
+		return sse2;
+
+	//AVX state needs OS support for the ymm (and for AVX-512 the opmask and zmm) registers
+	if (!osxsave || maxLeaf < 7)
+		return false;
+	std::uint64_t state = osSavedState();
+	bool avxState = (state & 0x6) == 0x6;
+	bool avx512State = (state & 0xE6) == 0xE6;
+
+	cpuid(7, 0, regs);
+	bool avx2 = (regs[1] >> 5) & 1;
+	bool avx512f = (regs[1] >> 16) & 1;
+	bool avx512bw = (regs[1] >> 30) & 1;
+
+	if (&kernels == &avx2DayKernels)
+		return avxState && avx2;
+	if (&kernels == &avx512DayKernels)
+		return avx512State && avx512f && avx512bw;
+
+	return false;
+}
+
+//every variant, best first
+const DayKernelTable* const allDayKernels[] = { &avx512DayKernels, &avx2DayKernels, &sse2DayKernels, &scalarDayKernels };
+
+#else
+
+bool cpuSupports(const DayKernelTable& kernels)
+{
+	return &kernels == &scalarDayKernels;
+}
+
+const DayKernelTable* const allDayKernels[] = { &scalarDayKernels };
+
+#endif
+
+const DayKernelTable* bestDayKernels()
+{
+	for (const DayKernelTable* kernels : allDayKernels)
+	{
+		if (cpuSupports(*kernels))
+			return kernels;
+	}
+
+	return &scalarDayKernels;
+}
+
+}
+
+const DayKernelTable scalarDayKernels = { "scalar", &scalarLeafMorningRow, &fireCheckRowScalar, &scalarRandomBlocks, &scalarRandomLaneBlocks };
+
+const DayKernelTable* dayKernels = bestDayKernels();
+
+const DayKernelTable& select_day_kernels(const char* requestedName)
+{
+	dayKernels = bestDayKernels();
+
+	if (requestedName)
+	{
+		for (const DayKernelTable* kernels : allDayKernels)
+		{
+			if (std::strcmp(kernels->name, requestedName) == 0 && cpuSupports(*kernels))
+				dayKernels = kernels;
+		}
+	}
+
+	return *dayKernels;
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include "ForestTypes.h"
+
+//x86 builds get the SSE2, AVX2 and AVX-512 kernel variants, picked at startup from CPUID
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define DAY_KERNELS_X86
+#endif
+
+//Change in a board's leaf totals caused by a kernel, added to the board with ForestBoard::addLeafTotals
+struct LeafTotalsDelta
+{
+	int emptyTiles = 0;
+	int saturatedTiles = 0;
+	std::int64_t leafVolume = 0;
+};
+
+//One board row as seen by the leaf/morning kernel
+struct LeafMorningRow
+{
+	volume_t* leaves;
+	const std::uint64_t* onFire; //bit plane row
+	const volume_t* leafIncrements; //pre-drawn leaf fall + growth for the day, ignored for burning tiles
+	int count;
+};
+
+//Per day constants of the leaf/morning kernel, all volumes in fixed point
+struct LeafMorningParams
+{
+	int rakeAmount; //0 on days without raking
+};
+
+//Burning neighbor counts of the 64 tiles in one fire state word, bit sliced: tile k has count bit0 + 2 * bit1 + 4 * bit2 taken from bit k of each plane.
+struct NeighborFireCounts
+{
+	std::uint64_t edge[3];
+	std::uint64_t corner[3];
+};
+
+//One board row as seen by the fire check kernel
+struct FireCheckRow
+{
+	const volume_t* leaves;
+	const std::uint64_t* onFire; //bit plane row
+	const NeighborFireCounts* neighbors; //one per word of the row
+	const std::uint64_t* draws; //one raw 64 bit random value per tile
+	std::uint64_t* ignitions; //output bit plane row, set for the tiles that catch fire
+	int count;
+};
+
+//Per day ignition thresholds of the fire check kernel, made with probabilityThreshold.
+//A tile not on fire ignites when its draw < season + leaf * leafUnit + neighbors[edges][corners], saturating
+struct FireCheckParams
+{
+	std::uint64_t season;
+	std::uint64_t leafUnit; //per thousandth of leaf volume, at most ~0 / volumeScale
+	std::uint64_t neighbors[5][5]; //by number of burning edge and corner neighbors
+};
+
+//Consecutive Philox4x32-10 blocks of the counter based random number generator (see CounterRandom).
+//Block b has counter { firstPair + b, day, trial, purpose } and writes its two 64 bit values to out[2 * b] and out[2 * b + 1]
+struct RandomBlocks
+{
+	std::uint32_t key[2];
+	std::uint32_t firstPair, day, trial, purpose;
+	std::uint64_t* out;
+	int count;
+};
+
+//Philox blocks with a counter of their own each, for the draws of many trials at once (see TrialLanes).
+//Block b has counter { pairs[b], days[b], trials[b], purpose } and writes its two 64 bit values to out[2 * b] and out[2 * b + 1]
+struct RandomLaneBlocks
+{
+	std::uint32_t key[2];
+	const std::uint32_t* pairs;
+	const std::uint32_t* days;
+	const std::uint32_t* trials;
+	std::uint32_t purpose;
+	std::uint64_t* out;
+	int count;
+};
+
+//One instruction set's build of the day kernels.
+//leafMorningRow: leaf update and raking of one row in one pass, computed with branchless clamps
+//and a masked select for the burning tiles. Fire starts and ends are events applied after it. Returns the change in the row's leaf totals.
+//fireCheckRow: ignition test of every tile of a row against its threshold. Words with no burning neighbors are screened
+//a vector of draws at a time against the largest threshold their tiles can have, only the draws below it get the exact test.
+//randomBlocks, randomLaneBlocks: Philox blocks, one block per 32 bit vector lane. Every variant gives the same values as the scalar one.
+struct DayKernelTable
+{
+	const char* name;
+	LeafTotalsDelta(*leafMorningRow)(const LeafMorningRow& row, const LeafMorningParams& params);
+	void(*fireCheckRow)(const FireCheckRow& row, const FireCheckParams& params);
+	void(*randomBlocks)(const RandomBlocks& blocks);
+	void(*randomLaneBlocks)(const RandomLaneBlocks& blocks);
+};
+
+extern const DayKernelTable scalarDayKernels;
+#ifdef DAY_KERNELS_X86
+extern const DayKernelTable sse2DayKernels;
+extern const DayKernelTable avx2DayKernels;
+extern const DayKernelTable avx512DayKernels;
+#endif
+
+//kernels in use, the best variant this CPU supports unless overridden with select_day_kernels
+extern const DayKernelTable* dayKernels;
+
+//Use the variant called requestedName ("scalar", "sse2", "avx2" or "avx512") if this CPU supports it,
+//otherwise (or for nullptr) the best supported variant. Returns the variant now in use.
+const DayKernelTable& select_day_kernels(const char* requestedName);
+
+inline LeafTotalsDelta leaf_morning_row(const LeafMorningRow& row, const LeafMorningParams& params)
+{
+	return dayKernels->leafMorningRow(row, params);
+}
+
+inline void fire_check_row(const FireCheckRow& row, const FireCheckParams& params)
+{
+	dayKernels->fireCheckRow(row, params);
+}
+
+inline void random_blocks(const RandomBlocks& blocks)
+{
+	dayKernels->randomBlocks(blocks);
+}
+
+inline void random_lane_blocks(const RandomLaneBlocks& blocks)
+{
+	dayKernels->randomLaneBlocks(blocks);
+}
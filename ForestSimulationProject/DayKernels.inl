@@ -0,0 +1,303 @@
+//Day kernel bodies, shared by every instruction set variant.
+//Each DayKernels*.cpp includes this inside an anonymous namespace after defining its lane type,
+//so every variant gets its own copy compiled with that file's instruction set.
+//A lane type has:
+//	vec, mask: a vector of volumes and a per lane mask, lanes: volumes per vec (8, 16 or 32)
+//	load, store, set1, add, minimum, subSaturate (floors at 0), equal, select (mask ? a : b)
+//	expandBits: mask of lanes bits of a bit plane
+//	countLanes
+//	zeroSum, addSum, reduceSum: running sum of (leaf - oldLeaf) in 32 bit lanes
+//	drawLanes, drawsBelow(draws, bound): bits of the drawLanes raw draws that are < bound.
+//		May also set bits of draws a little over bound (SSE2 has no 64 bit compare), the exact test follows
+//	randomLanes, set32, load32, laneIndex32 (0, 1, 2, ...), add32, xor32, store32, mulHiLo32(a, m, hi, lo): the 32 bit lane operations of Philox
+
+//number of set bits, without relying on a popcnt instruction
+inline int countBits(unsigned int bits)
+{
+	bits = bits - ((bits >> 1) & 0x55555555u);
+	bits = (bits & 0x33333333u) + ((bits >> 2) & 0x33333333u);
+	return int((((bits + (bits >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+}
+
+inline int minInt(int a, int b) { return a < b ? a : b; }
+inline int maxInt(int a, int b) { return a > b ? a : b; }
+
+//bit position of the lowest set bit of a non zero word
+inline int lowestBit(std::uint64_t bits)
+{
+	unsigned int low = unsigned(bits), high = unsigned(bits >> 32);
+	return low ? countBits((low & (0u - low)) - 1) : 32 + countBits((high & (0u - high)) - 1);
+}
+
+inline std::uint64_t addSaturate(std::uint64_t a, std::uint64_t b)
+{
+	std::uint64_t sum = a + b;
+	return sum < a ? ~std::uint64_t(0) : sum;
+}
+
+//count of a single tile from a bit sliced count
+inline int slicedCount(const std::uint64_t count[3], int bit)
+{
+	return int((count[0] >> bit) & 1) + 2 * int((count[1] >> bit) & 1) + 4 * int((count[2] >> bit) & 1);
+}
+
+//Leaf/morning update of tiles [first, row.count) one at a time. Reference implementation, and the tail of the vector kernels
+inline LeafTotalsDelta leafMorningRowScalar(const LeafMorningRow& row, const LeafMorningParams& params, int first)
+{
+	LeafTotalsDelta delta;
+
+	for (int j = first; j < row.count; ++j)
+	{
+		bool burning = ((row.onFire[j / tilesPerWord] >> (j % tilesPerWord)) & 1) != 0;
+
+		int oldLeaf = row.leaves[j];
+		int leaf = oldLeaf;
+
+		//leaf fall and growth for tiles not on fire, capped at 1
+		if (!burning)
+			leaf = minInt(leaf + row.leafIncrements[j], volumeScale);
+
+		//raking, floored at 0
+		leaf = maxInt(leaf - params.rakeAmount, 0);
+
+		row.leaves[j] = volume_t(leaf);
+
+		delta.emptyTiles += int(leaf == 0) - int(oldLeaf == 0);
+		delta.saturatedTiles += int(leaf == volumeScale) - int(oldLeaf == volumeScale);
+		delta.leafVolume += leaf - oldLeaf;
+	}
+
+	return delta;
+}
+
+//Leaf/morning update of a row, Lanes::lanes tiles at a time with branchless clamps and a masked select for the burning tiles
+template<typename Lanes>
+LeafTotalsDelta leafMorningRowSimd(const LeafMorningRow& row, const LeafMorningParams& params)
+{
+	typedef typename Lanes::vec vec;
+	typedef typename Lanes::mask mask;
+
+	const vec zero = Lanes::set1(0);
+	const vec scale = Lanes::set1(volumeScale);
+	const vec rake = Lanes::set1(params.rakeAmount);
+	const std::uint64_t laneBits = (std::uint64_t(1) << Lanes::lanes) - 1;
+
+	LeafTotalsDelta delta;
+	vec leafSum = Lanes::zeroSum();
+
+	int j = 0;
+	for (; j + Lanes::lanes <= row.count; j += Lanes::lanes)
+	{
+		int w = j / tilesPerWord;
+		int shift = j % tilesPerWord;
+		mask burning = Lanes::expandBits(unsigned((row.onFire[w] >> shift) & laneBits));
+
+		vec oldLeaf = Lanes::load(row.leaves + j);
+		vec increment = Lanes::load(row.leafIncrements + j);
+
+		//leaf fall and growth for tiles not on fire, capped at 1
+		vec leaf = Lanes::select(burning, oldLeaf, Lanes::minimum(Lanes::add(oldLeaf, increment), scale));
+
+		//raking, floored at 0
+		leaf = Lanes::subSaturate(leaf, rake);
+
+		Lanes::store(row.leaves + j, leaf);
+
+		delta.emptyTiles += Lanes::countLanes(Lanes::equal(leaf, zero)) - Lanes::countLanes(Lanes::equal(oldLeaf, zero));
+		delta.saturatedTiles += Lanes::countLanes(Lanes::equal(leaf, scale)) - Lanes::countLanes(Lanes::equal(oldLeaf, scale));
+		leafSum = Lanes::addSum(leafSum, leaf, oldLeaf);
+	}
+
+	delta.leafVolume = Lanes::reduceSum(leafSum);
+
+	//remaining tiles of the row
+	LeafTotalsDelta tail = leafMorningRowScalar(row, params, j);
+	delta.emptyTiles += tail.emptyTiles;
+	delta.saturatedTiles += tail.saturatedTiles;
+	delta.leafVolume += tail.leafVolume;
+
+	return delta;
+}
+
+//ignition threshold of tile j of a row
+inline std::uint64_t fireThreshold(const FireCheckRow& row, const FireCheckParams& params, int j)
+{
+	const NeighborFireCounts& counts = row.neighbors[j / tilesPerWord];
+	int bit = j % tilesPerWord;
+
+	std::uint64_t threshold = addSaturate(params.season, row.leaves[j] * params.leafUnit);
+	return addSaturate(threshold, params.neighbors[slicedCount(counts.edge, bit)][slicedCount(counts.corner, bit)]);
+}
+
+//Fire check of the tiles in word w of a row one at a time. Reference implementation, and the fallback of the vector kernels
+inline void fireCheckWordScalar(const FireCheckRow& row, const FireCheckParams& params, int w)
+{
+	int first = w * tilesPerWord;
+	int last = minInt(first + tilesPerWord, row.count);
+	std::uint64_t ignitions = 0;
+
+	for (int j = first; j < last; ++j)
+	{
+		std::uint64_t bit = std::uint64_t(1) << (j - first);
+		if (!(row.onFire[w] & bit) && row.draws[j] < fireThreshold(row, params, j))
+			ignitions |= bit;
+	}
+
+	row.ignitions[w] = ignitions;
+}
+
+inline void fireCheckRowScalar(const FireCheckRow& row, const FireCheckParams& params)
+{
+	int words = (row.count + tilesPerWord - 1) / tilesPerWord;
+	for (int w = 0; w < words; ++w)
+		fireCheckWordScalar(row, params, w);
+}
+
+//Fire check of a row. Away from fires every tile's threshold is at most season + a full leaf volume,
+//so a whole word is screened Lanes::drawLanes draws at a time against that bound and only the few draws below it
+//(about p_fire of them) get the exact per tile threshold. Words next to a fire and the partial last word go tile by tile.
+template<typename Lanes>
+void fireCheckRowSimd(const FireCheckRow& row, const FireCheckParams& params)
+{
+	const std::uint64_t bound = addSaturate(params.season, volumeScale * params.leafUnit);
+	int words = (row.count + tilesPerWord - 1) / tilesPerWord;
+
+	for (int w = 0; w < words; ++w)
+	{
+		const NeighborFireCounts& counts = row.neighbors[w];
+		std::uint64_t neighbors = counts.edge[0] | counts.edge[1] | counts.edge[2] | counts.corner[0] | counts.corner[1] | counts.corner[2];
+		int first = w * tilesPerWord;
+
+		if (neighbors != 0 || first + tilesPerWord > row.count)
+		{
+			fireCheckWordScalar(row, params, w);
+			continue;
+		}
+
+		std::uint64_t candidates = 0;
+		for (int k = 0; k < tilesPerWord; k += Lanes::drawLanes)
+			candidates |= std::uint64_t(Lanes::drawsBelow(row.draws + first + k, bound)) << k;
+		candidates &= ~row.onFire[w];
+
+		std::uint64_t ignitions = 0;
+		while (candidates)
+		{
+			int bit = lowestBit(candidates);
+			candidates &= candidates - 1;
+			if (row.draws[first + bit] < fireThreshold(row, params, first + bit))
+				ignitions |= std::uint64_t(1) << bit;
+		}
+
+		row.ignitions[w] = ignitions;
+	}
+}
+
+//Philox4x32 multipliers and key increments (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3")
+const std::uint32_t philoxM0 = 0xD2511F53u;
+const std::uint32_t philoxM1 = 0xCD9E8D57u;
+const std::uint32_t philoxW0 = 0x9E3779B9u;
+const std::uint32_t philoxW1 = 0xBB67AE85u;
+const int philoxRounds = 10;
+
+//One Philox block of counter { c0, c1, c2, c3 } and key { k0, k1 }, its two 64 bit values to out[0] and out[1]
+inline void philoxBlock(std::uint32_t c0, std::uint32_t c1, std::uint32_t c2, std::uint32_t c3, std::uint32_t k0, std::uint32_t k1, std::uint64_t* out)
+{
+	for (int round = 0; round < philoxRounds; ++round)
+	{
+		std::uint64_t p0 = std::uint64_t(philoxM0) * c0;
+		std::uint64_t p1 = std::uint64_t(philoxM1) * c2;
+		c0 = std::uint32_t(p1 >> 32) ^ c1 ^ k0;
+		c1 = std::uint32_t(p1);
+		c2 = std::uint32_t(p0 >> 32) ^ c3 ^ k1;
+		c3 = std::uint32_t(p0);
+		k0 += philoxW0;
+		k1 += philoxW1;
+	}
+
+	out[0] = (std::uint64_t(c1) << 32) | c0;
+	out[1] = (std::uint64_t(c3) << 32) | c2;
+}
+
+//Philox blocks [first, blocks.count) one at a time. Reference implementation, and the tail of the vector kernels
+inline void randomBlocksScalar(const RandomBlocks& blocks, int first)
+{
+	for (int b = first; b < blocks.count; ++b)
+		philoxBlock(blocks.firstPair + std::uint32_t(b), blocks.day, blocks.trial, blocks.purpose, blocks.key[0], blocks.key[1], blocks.out + 2 * b);
+}
+
+inline void randomLaneBlocksScalar(const RandomLaneBlocks& blocks, int first)
+{
+	for (int b = first; b < blocks.count; ++b)
+		philoxBlock(blocks.pairs[b], blocks.days[b], blocks.trials[b], blocks.purpose, blocks.key[0], blocks.key[1], blocks.out + 2 * b);
+}
+
+//Philox blocks of the counters in c0 .. c3, one per 32 bit lane, to out[2 * l] and out[2 * l + 1] for lane l
+template<typename Lanes>
+void philoxLanes(typename Lanes::vec c0, typename Lanes::vec c1, typename Lanes::vec c2, typename Lanes::vec c3, std::uint32_t k0, std::uint32_t k1, std::uint64_t* out)
+{
+	typedef typename Lanes::vec vec;
+
+	for (int round = 0; round < philoxRounds; ++round)
+	{
+		vec hi0, lo0, hi1, lo1;
+		Lanes::mulHiLo32(c0, philoxM0, hi0, lo0);
+		Lanes::mulHiLo32(c2, philoxM1, hi1, lo1);
+		c0 = Lanes::xor32(Lanes::xor32(hi1, c1), Lanes::set32(k0));
+		c1 = lo1;
+		c2 = Lanes::xor32(Lanes::xor32(hi0, c3), Lanes::set32(k1));
+		c3 = lo0;
+		k0 += philoxW0;
+		k1 += philoxW1;
+	}
+
+	std::uint32_t words[4][Lanes::randomLanes];
+	Lanes::store32(words[0], c0);
+	Lanes::store32(words[1], c1);
+	Lanes::store32(words[2], c2);
+	Lanes::store32(words[3], c3);
+	for (int l = 0; l < Lanes::randomLanes; ++l)
+	{
+		out[2 * l] = (std::uint64_t(words[1][l]) << 32) | words[0][l];
+		out[2 * l + 1] = (std::uint64_t(words[3][l]) << 32) | words[2][l];
+	}
+}
+
+//Philox blocks, Lanes::randomLanes blocks at a time, one per 32 bit lane
+template<typename Lanes>
+void randomBlocksSimd(const RandomBlocks& blocks)
+{
+	typedef typename Lanes::vec vec;
+
+	const vec c1 = Lanes::set32(blocks.day);
+	const vec c2 = Lanes::set32(blocks.trial);
+	const vec c3 = Lanes::set32(blocks.purpose);
+
+	int b = 0;
+	for (; b + Lanes::randomLanes <= blocks.count; b += Lanes::randomLanes)
+	{
+		vec c0 = Lanes::add32(Lanes::set32(blocks.firstPair + std::uint32_t(b)), Lanes::laneIndex32());
+		philoxLanes<Lanes>(c0, c1, c2, c3, blocks.key[0], blocks.key[1], blocks.out + 2 * b);
+	}
+
+	randomBlocksScalar(blocks, b);
+}
+
+//Philox blocks with a counter of their own each, Lanes::randomLanes blocks at a time
+template<typename Lanes>
+void randomLaneBlocksSimd(const RandomLaneBlocks& blocks)
+{
+	typedef typename Lanes::vec vec;
+
+	const vec c3 = Lanes::set32(blocks.purpose);
+
+	int b = 0;
+	for (; b + Lanes::randomLanes <= blocks.count; b += Lanes::randomLanes)
+	{
+		vec c0 = Lanes::load32(blocks.pairs + b);
+		vec c1 = Lanes::load32(blocks.days + b);
+		vec c2 = Lanes::load32(blocks.trials + b);
+		philoxLanes<Lanes>(c0, c1, c2, c3, blocks.key[0], blocks.key[1], blocks.out + 2 * b);
+	}
+
+	randomLaneBlocksScalar(blocks, b);
+}
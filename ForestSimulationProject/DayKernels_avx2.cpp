@@ -0,0 +1,87 @@
+//AVX2 build of the day kernels, 16 tiles per vector. Only called on CPUs that report AVX2
+#include "DayKernels.h"
+
+#ifdef DAY_KERNELS_X86
+
+#if defined(__GNUC__)
+#pragma GCC target("avx2")
+#endif
+#include <immintrin.h>
+
+namespace
+{
+
+#include "DayKernels.inl"
+
+struct Avx2Lanes
+{
+	typedef __m256i vec;
+	typedef __m256i mask;
+	static const int lanes = 16;
+
+	static vec load(const volume_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+	static void store(volume_t* p, vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+	static vec set1(int v) { return _mm256_set1_epi16(short(v)); }
+	static vec add(vec a, vec b) { return _mm256_add_epi16(a, b); }
+	static vec minimum(vec a, vec b) { return _mm256_min_epu16(a, b); }
+	static vec subSaturate(vec a, vec b) { return _mm256_subs_epu16(a, b); }
+	static mask equal(vec a, vec b) { return _mm256_cmpeq_epi16(a, b); }
+	static vec select(mask m, vec a, vec b) { return _mm256_blendv_epi8(b, a, m); }
+
+	static mask expandBits(unsigned int bits)
+	{
+		const __m256i laneBits = _mm256_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128,
+			256, 512, 1024, 2048, 4096, 8192, 16384, short(0x8000));
+		return _mm256_cmpeq_epi16(_mm256_and_si256(_mm256_set1_epi16(short(bits)), laneBits), laneBits);
+	}
+
+	static int countLanes(mask m) { return countBits(unsigned(_mm256_movemask_epi8(m))) / 2; } //2 bits per 16 bit lane
+
+	static vec zeroSum() { return _mm256_setzero_si256(); }
+	static vec addSum(vec sum, vec leaf, vec oldLeaf)
+	{
+		const __m256i ones = _mm256_set1_epi16(1);
+		return _mm256_add_epi32(sum, _mm256_sub_epi32(_mm256_madd_epi16(leaf, ones), _mm256_madd_epi16(oldLeaf, ones)));
+	}
+	static std::int64_t reduceSum(vec sum)
+	{
+		alignas(32) int parts[8];
+		_mm256_store_si256(reinterpret_cast<__m256i*>(parts), sum);
+		std::int64_t total = 0;
+		for (int k = 0; k < 8; ++k) total += parts[k];
+		return total;
+	}
+
+	//unsigned compare as a signed one with the sign bits flipped
+	static const int drawLanes = 4;
+	static unsigned int drawsBelow(const std::uint64_t* draws, std::uint64_t bound)
+	{
+		const __m256i sign = _mm256_set1_epi64x(std::int64_t(std::uint64_t(1) << 63));
+		__m256i d = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(draws)), sign);
+		__m256i b = _mm256_xor_si256(_mm256_set1_epi64x(std::int64_t(bound)), sign);
+		return unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(b, d))));
+	}
+
+	static const int randomLanes = 8;
+	static vec set32(std::uint32_t v) { return _mm256_set1_epi32(int(v)); }
+	static vec load32(const std::uint32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+	static vec laneIndex32() { return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7); }
+	static vec add32(vec a, vec b) { return _mm256_add_epi32(a, b); }
+	static vec xor32(vec a, vec b) { return _mm256_xor_si256(a, b); }
+	static void store32(std::uint32_t* p, vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+	static void mulHiLo32(vec a, std::uint32_t m, vec& hi, vec& lo)
+	{
+		//full products of the even lanes, then of the odd lanes shifted down
+		__m256i mv = _mm256_set1_epi32(int(m));
+		__m256i even = _mm256_mul_epu32(a, mv);
+		__m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), mv);
+		lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+		hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+	}
+};
+
+}
+
+const DayKernelTable avx2DayKernels = { "avx2", &leafMorningRowSimd<Avx2Lanes>, &fireCheckRowSimd<Avx2Lanes>, &randomBlocksSimd<Avx2Lanes>, &randomLaneBlocksSimd<Avx2Lanes> };
+
+#endif
@@ -0,0 +1,82 @@
+//AVX-512 (F + BW) build of the day kernels, 32 tiles per vector with mask registers. Only called on CPUs that report AVX-512 F and BW
+#include "DayKernels.h"
+
+#ifdef DAY_KERNELS_X86
+
+#if defined(__GNUC__)
+#pragma GCC target("avx512f,avx512bw")
+//GCC's own AVX-512 headers start some intrinsics from _mm512_undefined_epi32() and trip these warnings
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#endif
+#include <immintrin.h>
+
+namespace
+{
+
+#include "DayKernels.inl"
+
+struct Avx512Lanes
+{
+	typedef __m512i vec;
+	typedef __mmask32 mask;
+	static const int lanes = 32;
+
+	static vec load(const volume_t* p) { return _mm512_loadu_si512(p); }
+	static void store(volume_t* p, vec v) { _mm512_storeu_si512(p, v); }
+	static vec set1(int v) { return _mm512_set1_epi16(short(v)); }
+	static vec add(vec a, vec b) { return _mm512_add_epi16(a, b); }
+	static vec minimum(vec a, vec b) { return _mm512_min_epu16(a, b); }
+	static vec subSaturate(vec a, vec b) { return _mm512_subs_epu16(a, b); }
+	static mask equal(vec a, vec b) { return _mm512_cmpeq_epi16_mask(a, b); }
+	static vec select(mask m, vec a, vec b) { return _mm512_mask_blend_epi16(m, b, a); }
+
+	//bit plane bits are already a lane mask
+	static mask expandBits(unsigned int bits) { return mask(bits); }
+
+	static int countLanes(mask m) { return countBits(unsigned(m)); }
+
+	static vec zeroSum() { return _mm512_setzero_si512(); }
+	static vec addSum(vec sum, vec leaf, vec oldLeaf)
+	{
+		const __m512i ones = _mm512_set1_epi16(1);
+		return _mm512_add_epi32(sum, _mm512_sub_epi32(_mm512_madd_epi16(leaf, ones), _mm512_madd_epi16(oldLeaf, ones)));
+	}
+	static std::int64_t reduceSum(vec sum)
+	{
+		alignas(64) int parts[16];
+		_mm512_store_si512(parts, sum);
+		std::int64_t total = 0;
+		for (int k = 0; k < 16; ++k) total += parts[k];
+		return total;
+	}
+
+	static const int drawLanes = 8;
+	static unsigned int drawsBelow(const std::uint64_t* draws, std::uint64_t bound)
+	{
+		return unsigned(_mm512_cmplt_epu64_mask(_mm512_loadu_si512(draws), _mm512_set1_epi64(std::int64_t(bound))));
+	}
+
+	static const int randomLanes = 16;
+	static vec set32(std::uint32_t v) { return _mm512_set1_epi32(int(v)); }
+	static vec load32(const std::uint32_t* p) { return _mm512_loadu_si512(p); }
+	static vec laneIndex32() { return _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15); }
+	static vec add32(vec a, vec b) { return _mm512_add_epi32(a, b); }
+	static vec xor32(vec a, vec b) { return _mm512_xor_si512(a, b); }
+	static void store32(std::uint32_t* p, vec v) { _mm512_storeu_si512(p, v); }
+	static void mulHiLo32(vec a, std::uint32_t m, vec& hi, vec& lo)
+	{
+		//full products of the even lanes, then of the odd lanes shifted down
+		__m512i mv = _mm512_set1_epi32(int(m));
+		__m512i even = _mm512_mul_epu32(a, mv);
+		__m512i odd = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), mv);
+		lo = _mm512_mask_blend_epi32(0xAAAA, even, _mm512_slli_epi64(odd, 32));
+		hi = _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(even, 32), odd);
+	}
+};
+
+}
+
+const DayKernelTable avx512DayKernels = { "avx512", &leafMorningRowSimd<Avx512Lanes>, &fireCheckRowSimd<Avx512Lanes>, &randomBlocksSimd<Avx512Lanes>, &randomLaneBlocksSimd<Avx512Lanes> };
+
+#endif
@@ -0,0 +1,86 @@
+//SSE2 build of the day kernels, 8 tiles per vector
+#include "DayKernels.h"
+
+#ifdef DAY_KERNELS_X86
+
+#if defined(__GNUC__)
+#pragma GCC target("sse2")
+#endif
+#include <emmintrin.h>
+
+namespace
+{
+
+#include "DayKernels.inl"
+
+struct Sse2Lanes
+{
+	typedef __m128i vec;
+	typedef __m128i mask;
+	static const int lanes = 8;
+
+	static vec load(const volume_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+	static void store(volume_t* p, vec v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+	static vec set1(int v) { return _mm_set1_epi16(short(v)); }
+	static vec add(vec a, vec b) { return _mm_add_epi16(a, b); }
+	static vec minimum(vec a, vec b) { return _mm_min_epi16(a, b); } //volumes fit in a signed 16 bit lane
+	static vec subSaturate(vec a, vec b) { return _mm_subs_epu16(a, b); }
+	static mask equal(vec a, vec b) { return _mm_cmpeq_epi16(a, b); }
+	static vec select(mask m, vec a, vec b) { return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)); }
+
+	static mask expandBits(unsigned int bits)
+	{
+		const __m128i laneBits = _mm_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128);
+		return _mm_cmpeq_epi16(_mm_and_si128(_mm_set1_epi16(short(bits)), laneBits), laneBits);
+	}
+
+	static int countLanes(mask m) { return countBits(unsigned(_mm_movemask_epi8(m))) / 2; } //2 bits per 16 bit lane
+
+	static vec zeroSum() { return _mm_setzero_si128(); }
+	static vec addSum(vec sum, vec leaf, vec oldLeaf)
+	{
+		const __m128i ones = _mm_set1_epi16(1);
+		return _mm_add_epi32(sum, _mm_sub_epi32(_mm_madd_epi16(leaf, ones), _mm_madd_epi16(oldLeaf, ones)));
+	}
+	static std::int64_t reduceSum(vec sum)
+	{
+		alignas(16) int parts[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(parts), sum);
+		return std::int64_t(parts[0]) + parts[1] + parts[2] + parts[3];
+	}
+
+	//no 64 bit compare in SSE2: compares the high halves only, so draws with the same high half as bound pass as well
+	static const int drawLanes = 2;
+	static unsigned int drawsBelow(const std::uint64_t* draws, std::uint64_t bound)
+	{
+		const __m128i sign = _mm_set1_epi32(int(0x80000000u));
+		__m128i d = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(draws)), sign);
+		__m128i b = _mm_xor_si128(_mm_set1_epi32(int(unsigned(bound >> 32))), sign);
+		unsigned int above = unsigned(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(d, b))));
+		return ~((above >> 1 & 1) | (above >> 2 & 2)) & 3;
+	}
+
+	static const int randomLanes = 4;
+	static vec set32(std::uint32_t v) { return _mm_set1_epi32(int(v)); }
+	static vec load32(const std::uint32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+	static vec laneIndex32() { return _mm_setr_epi32(0, 1, 2, 3); }
+	static vec add32(vec a, vec b) { return _mm_add_epi32(a, b); }
+	static vec xor32(vec a, vec b) { return _mm_xor_si128(a, b); }
+	static void store32(std::uint32_t* p, vec v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+	static void mulHiLo32(vec a, std::uint32_t m, vec& hi, vec& lo)
+	{
+		//full products of the even lanes, then of the odd lanes shifted down
+		const __m128i low = _mm_setr_epi32(-1, 0, -1, 0);
+		__m128i mv = _mm_set1_epi32(int(m));
+		__m128i even = _mm_mul_epu32(a, mv);
+		__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), mv);
+		lo = _mm_or_si128(_mm_and_si128(even, low), _mm_slli_epi64(odd, 32));
+		hi = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(low, odd));
+	}
+};
+
+}
+
+const DayKernelTable sse2DayKernels = { "sse2", &leafMorningRowSimd<Sse2Lanes>, &fireCheckRowSimd<Sse2Lanes>, &randomBlocksSimd<Sse2Lanes>, &randomLaneBlocksSimd<Sse2Lanes> };
+
+#endif
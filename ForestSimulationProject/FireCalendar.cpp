@@ -0,0 +1,42 @@
+#include "FireCalendar.h"
+#include <algorithm>
+
+FireCalendar::FireCalendar(int maxDelay)
+{
+	//a power of two past maxDelay, so the days in flight never share a bucket
+	int size = 1;
+	while (size <= maxDelay)
+		size *= 2;
+
+	buckets.resize(size);
+	mask = size - 1;
+}
+
+void FireCalendar::schedule(int day, const FireEvent& event)
+{
+	buckets[day & mask].push_back(event);
+	++pending;
+}
+
+const std::vector<FireEvent>& FireCalendar::eventsOf(int day)
+{
+	std::vector<FireEvent>& events = buckets[day & mask];
+	std::sort(events.begin(), events.end(), [](const FireEvent& a, const FireEvent& b)
+	{
+		return a.tile != b.tile ? a.tile < b.tile : (!a.start && b.start);
+	});
+	return events;
+}
+
+void FireCalendar::finishDay(int day)
+{
+	pending -= int(buckets[day & mask].size());
+	buckets[day & mask].clear();
+}
+
+void FireCalendar::clear()
+{
+	for (std::vector<FireEvent>& events : buckets)
+		events.clear();
+	pending = 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+
+//A fire starting or ending on a tile, at the flat index row * width + col
+struct FireEvent
+{
+	int tile;
+	bool start;
+};
+
+//Fire starts and ends of a trial, kept on a timing wheel with one bucket per day, so a morning only visits the tiles
+//whose fire state changes that day instead of checking every burning tile for its end time.
+//Events can be scheduled up to maxDelay days after the day being simulated.
+class FireCalendar
+{
+public:
+	explicit FireCalendar(int maxDelay);
+
+	//add an event for day, which has to be after today and at most maxDelay days away
+	void schedule(int day, const FireEvent& event);
+
+	//the events of day, sorted by tile, with a tile's end before its start
+	const std::vector<FireEvent>& eventsOf(int day);
+
+	//drop the events of day once they have been applied, making room for the day maxDelay + 1 days later
+	void finishDay(int day);
+
+	void clear();
+
+	//no events scheduled for any day
+	bool isEmpty() const { return pending == 0; }
+
+private:
+	std::vector<std::vector<FireEvent>> buckets; //day & mask
+	int mask;
+	int pending = 0;
+};
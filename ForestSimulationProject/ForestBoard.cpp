@@ -2,7 +2,8 @@
 #include <iostream>
 #include <thread>
 
-ForestBoard::ForestBoard(int height, int width) : height(height), width(width)
+ForestBoard::ForestBoard(int height, int width, int nutrientDepletion) : height(height), width(width), wordsPerRow((width + tilesPerWord - 1) / tilesPerWord), wordStride(wordsPerRow + 2),
+	nutrientDepletion(nutrientDepletion)
 {
 #ifdef VISUALIZE
 	//create the window
@@ -33,11 +34,18 @@ ForestBoard::ForestBoard(int height, int width) : height(height), width(width)
 	tileSprite.rect.setOutlineThickness(4);
 #endif
 
-	//create the board
-	board = new ForestTile*[height];
+	//create the board, one zeroed array per field
+	size_t numTiles = size_t(height) * size_t(width);
+	leafVolumes.resize(numTiles);
+	nutrientVolumes.resize(numTiles);
+	nutrientDays.resize(numTiles);
+	onFireBits.resize(size_t(height + 2) * size_t(wordStride));
+	burningPerRow.resize(size_t(height + 2));
+	saturatedWords.resize(size_t(height) * size_t(wordsPerRow));
 
-	for (int i = 0; i < height; i++)
-		board[i] = new ForestTile[width];
+	totalLeafVolume = 0;
+	emptyTiles = height * width;
+	saturatedTiles = 0;
 
 #ifdef VISUALIZE
 	//draw the board
@@ -50,10 +58,6 @@ ForestBoard::ForestBoard(int height, int width) : height(height), width(width)
 
 ForestBoard::~ForestBoard()
 {
-	for (int i = 0; i < height; i++)
-		delete[] board[i];
-
-	delete[] board;
 }
 
 void ForestBoard::drawTile(int row, int col)
@@ -63,18 +67,20 @@ void ForestBoard::drawTile(int row, int col)
 		//set the tileSprite position
 		tileSprite.rect.setPosition(col * tileSprite.rect.getSize().x, row * tileSprite.rect.getSize().y);
 
-		if(board[row][col].isOnFire) //if on fire, color red
+		double leaf = volumeToDouble(leafVolume(row, col));
+
+		if(isOnFire(row, col)) //if on fire, color red
 			tileSprite.rect.setFillColor(sf::Color(255, 0, 0));
-		else if(board[row][col].leafVolume == 0)
+		else if(leaf == 0)
 			tileSprite.rect.setFillColor(sf::Color(255, 255, 255)); //white
 		else //else color shade of green
-			tileSprite.rect.setFillColor(sf::Color(0, std::max(int(255 - (255 * board[row][col].leafVolume)), 0), 0));
+			tileSprite.rect.setFillColor(sf::Color(0, std::max(int(255 - (255 * leaf)), 0), 0));
 
 		//draw the rectangle
 		window.draw(tileSprite.rect);
 
 		//update values + draw the text
-		tileSprite.text.setString(std::to_string(board[row][col].leafVolume));
+		tileSprite.text.setString(std::to_string(leaf));
 		tileSprite.text.setPosition(tileSprite.rect.getPosition());
 		window.draw(tileSprite.text);
 	}
@@ -108,13 +114,18 @@ void ForestBoard::display()
 	handleInputEvents();
 }
 
-//returns nullptr if invalid row/col
-ForestTile * ForestBoard::getForestTile(int row, int col)
+void ForestBoard::reset()
 {
-	if (isValidTile(row, col, "getForestTile"))
-		return &board[row][col];	
-
-	return nullptr;
+	leafVolumes.clear();
+	nutrientVolumes.clear();
+	nutrientDays.clear();
+	onFireBits.clear();
+	burningPerRow.clear();
+	saturatedWords.clear();
+
+	totalLeafVolume = 0;
+	emptyTiles = height * width;
+	saturatedTiles = 0;
 }
 
 bool ForestBoard::isValidTile(int row, int col)
@@ -122,7 +133,7 @@ bool ForestBoard::isValidTile(int row, int col)
 	return (row >= 0 && col >= 0 && row < height && col < width);
 }
 
-bool ForestBoard::isValidTile(int row, int col, std::string funcName)
+bool ForestBoard::isValidTile(int row, int col, const char* funcName)
 {
 	if (!isValidTile(row, col))
 	{
@@ -1,19 +1,13 @@
 #pragma once
 #include <SFML/Graphics.hpp>
+#include <cstdint>
+#include "AlignedArray.h"
+#include "ForestTypes.h"
 
 //define this here, so it's easier to modify I guess...
 //#define VISUALIZE
 constexpr int numTrials = 1000;
 
-struct ForestTile
-{
-	double leafVolume = 0;
-	bool isOnFire = false;
-	bool willBeOnFire = false;
-	int fireEndTime = 0;
-	double nutrientVolume = 0;
-};
-
 struct TileSprite
 {
 	sf::Text text;
@@ -21,6 +15,46 @@ struct TileSprite
 	sf::Font font;
 };
 
+//Fixed 8 neighbor stencil as (row, col) offsets
+struct StencilOffset
+{
+	int row, col;
+};
+
+constexpr StencilOffset edgeStencil[4] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+constexpr StencilOffset cornerStencil[4] = { { -1, -1 }, { -1, 1 }, { 1, -1 }, { 1, 1 } };
+
+//Tile accessors only check bounds in debug builds, hot loops pay nothing for them in release
+#if defined(_DEBUG) && !defined(BOUNDS_CHECK_TILES)
+#define BOUNDS_CHECK_TILES
+#endif
+
+//Unchecked view of one row of a grid field, usable with range-for
+template<typename T>
+struct RowSpan
+{
+	T* first;
+	int count;
+
+	T* begin() const { return first; }
+	T* end() const { return first + count; }
+	T& operator[](int col) const { return first[col]; }
+	int size() const { return count; }
+};
+
+//test the bit of tile col in a fire state bit plane row
+inline bool tileBit(const std::uint64_t* row, int col)
+{
+	return (row[col / tilesPerWord] >> (col % tilesPerWord)) & 1;
+}
+
+//The grid is stored as a structure of arrays, one aligned row-major array per tile field,
+//so a pass that only needs one field (e.g. leaf volume) only streams that field through cache.
+//The fire state is a bit plane, each row packed 64 tiles per word (tile col is bit col % 64 of word col / 64).
+//When fires start and end is not stored per tile, the simulation keeps those as events (see FireCalendar).
+//The bit plane has a ghost border that always stays zero: one ghost row above and below the board,
+//one ghost word left and right of every row, and the unused bits past the last column,
+//so any stencil offset of a real tile reads valid memory without bounds checks.
 class ForestBoard
 {
 public:
@@ -29,19 +63,151 @@ public:
 
 	void display();
 
-	ForestTile* getForestTile(int row, int col);
+	//per field tile accessors, bounds checked in debug builds only
+	volume_t leafVolume(int row, int col) { return leafVolumes[tileIndex(row, col, "leafVolume")]; }
+	void setLeafVolume(int row, int col, int leafVolume) { setLeafVolume(tileIndex(row, col, "setLeafVolume"), leafVolume); }
+	volume_t nutrientVolume(int row, int col, int day) { return nutrientVolume(tileIndex(row, col, "nutrientVolume"), day); }
+	bool isOnFire(int row, int col) { return tileBit(&onFireBits[bitIndex(row, 0, "isOnFire")], col); }
+	void setOnFire(int row, int col, bool onFire)
+	{
+		if (onFire)
+			saturatedWords[size_t(row) * wordsPerRow + col / tilesPerWord] = 0;
+		burningPerRow[row + 1] += int(onFire) - int(isOnFire(row, col));
+		setTileBit(onFireBits, row, col, onFire, "setOnFire");
+	}
+
+	//flat index accessors, index is row * width + col
+	volume_t leafVolume(int index) const { return leafVolumes[index]; }
+
+	//nutrients are stored as their volume on the day they were last set, and deplete by nutrientDepletion a day from there
+	//(floored at 0), so the days in between don't touch them. The volume of a tile on a day, after that day's depletion
+	volume_t nutrientVolume(int index, int day) const
+	{
+		std::int64_t volume = nutrientVolumes[index] - std::int64_t(nutrientDepletion) * (day - nutrientDays[index]);
+		return volume_t(volume > 0 ? volume : 0);
+	}
+	void setNutrientVolume(int index, int day, int nutrientVolume)
+	{
+		nutrientVolumes[index] = volume_t(nutrientVolume);
+		nutrientDays[index] = day;
+	}
+
+	//also keeps the leaf totals below up to date
+	void setLeafVolume(int index, int leafVolume)
+	{
+		volume_t& tile = leafVolumes[index];
+
+		//move the tile between the empty/saturated counts and update the total
+		emptyTiles += int(leafVolume == 0) - int(tile == 0);
+		saturatedTiles += int(leafVolume == volumeScale) - int(tile == volumeScale);
+		totalLeafVolume += leafVolume - tile;
+
+		tile = volume_t(leafVolume);
+		if (leafVolume != volumeScale)
+			saturatedWords[size_t(index / width) * wordsPerRow + (index % width) / tilesPerWord] = 0;
+	}
+
+	//unchecked row spans for hot loops. Leaf volumes are read only, writes go through setLeafVolume
+	RowSpan<const volume_t> leafRow(int row) const { return { &leafVolumes[size_t(row) * width], width }; }
+
+	//unchecked writable rows for the vectorized day kernels. Leaf writes through leafRowUntracked
+	//bypass the leaf totals, the kernel's change to them has to be passed to addLeafTotals
+	RowSpan<volume_t> leafRowUntracked(int row) { return { &leafVolumes[size_t(row) * width], width }; }
+	void addLeafTotals(int emptyTilesDelta, int saturatedTilesDelta, std::int64_t leafVolumeDelta)
+	{
+		emptyTiles += emptyTilesDelta;
+		saturatedTiles += saturatedTilesDelta;
+		totalLeafVolume += leafVolumeDelta;
+	}
+
+	//number of burning tiles in a row, so fire neighbor work can skip the rows far from any fire.
+	//row may be -1 or height (ghost rows, always 0). Kept up to date by setOnFire
+	int burningTiles(int row) const { return burningPerRow[row + 1]; }
+
+	//words of a row (tilesPerWord tiles, as in the bit plane) whose tiles are all full of leaves, so none of them burns.
+	//A set flag is always right, a clear one may be out of date: the leaf pass sets them, setLeafVolume and setOnFire clear them,
+	//and writes through leafRowUntracked have to
+	bool isSaturatedWord(int row, int word) const { return saturatedWords[size_t(row) * wordsPerRow + word] != 0; }
+	void setSaturatedWord(int row, int word, bool saturated) { saturatedWords[size_t(row) * wordsPerRow + word] = std::uint8_t(saturated); }
+
+	//fire state bit plane rows, for word parallel neighbor counting and bit tests with tileBit.
+	//row may be -1 or height (ghost rows), and words -1 and getWordsPerRow() of a row are ghost words
+	const std::uint64_t* onFireRow(int row) const { return &onFireBits[bitIndex(row, 0)]; }
+	int getWordsPerRow() const { return wordsPerRow; }
+
+	//running leaf totals, maintained by setLeafVolume
+	std::int64_t getTotalLeafVolume() const { return totalLeafVolume; }
+	int getEmptyTiles() const { return emptyTiles; }
+	int getSaturatedTiles() const { return saturatedTiles; }
+	int getNumTiles() const { return height * width; }
+
+	//clear every tile back to its initial state, keeping the allocation for the next trial
+	void reset();
+
 	bool isValidTile(int row, int col);
 
+	int getHeight() const { return height; }
+	int getWidth() const { return width; }
+
 	void handleInputEvents();
 
-	ForestBoard(int height, int width);
+	ForestBoard(int height, int width, int nutrientDepletion);
 	~ForestBoard();
 private:
-	bool isValidTile(int row, int col, std::string funcName);
-	
+	bool isValidTile(int row, int col, const char* funcName);
+
+	//flat index of a tile in the field arrays. In debug builds aborts if invalid row/col
+	int tileIndex(int row, int col, const char* funcName)
+	{
+#ifdef BOUNDS_CHECK_TILES
+		if (!isValidTile(row, col, funcName))
+			abort();
+#else
+		(void)funcName;
+#endif
+		return row * width + col;
+	}
+
+	//index of the bit plane word holding tile (row, col)
+	int bitIndex(int row, int col) const { return (row + 1) * wordStride + 1 + col / tilesPerWord; }
+	int bitIndex(int row, int col, const char* funcName)
+	{
+		tileIndex(row, col, funcName);
+		return bitIndex(row, col);
+	}
+
+	void setTileBit(AlignedArray<std::uint64_t>& plane, int row, int col, bool value, const char* funcName)
+	{
+		std::uint64_t& word = plane[bitIndex(row, col, funcName)];
+		std::uint64_t mask = std::uint64_t(1) << (col % tilesPerWord);
+		word = value ? (word | mask) : (word & ~mask);
+	}
+
 	int width, height;
-	ForestTile** board;
+	int wordsPerRow;
+	int wordStride; //words per bit plane row including the two ghost words
+
+	//grid fields, indexed by row * width + col
+	AlignedArray<volume_t> leafVolumes;
+	AlignedArray<volume_t> nutrientVolumes; //on nutrientDays
+	AlignedArray<int> nutrientDays;
+	int nutrientDepletion; //per day
+
+	//fire state bit plane, indexed by bitIndex(row, col)
+	AlignedArray<std::uint64_t> onFireBits;
+
+	//burning tiles per row, indexed by row + 1 like the bit plane rows
+	AlignedArray<int> burningPerRow;
+
+	//saturated word flags, indexed by row * wordsPerRow + word
+	AlignedArray<std::uint8_t> saturatedWords;
+
+	//total leaf volume in thousandths, and number of tiles with no leaves / full of leaves
+	std::int64_t totalLeafVolume;
+	int emptyTiles;
+	int saturatedTiles;
+
 	sf::RenderWindow window;
 
 	TileSprite tileSprite;
-};
\ No newline at end of file
+};
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+
+//Basic grid types shared by the board and the day kernels. Kept free of other includes,
+//since the kernel files compiled for newer instruction sets include it too
+
+//Leaf and nutrient volumes are fixed point integers counting thousandths of a full tile, 0 .. volumeScale.
+//Every volume change in the model is a whole number of thousandths, so the fixed point values are exact
+typedef std::uint16_t volume_t;
+constexpr int volumeScale = 1000;
+
+inline double volumeToDouble(int volume)
+{
+	return double(volume) / volumeScale;
+}
+
+//number of tiles packed into one word of a fire state bit plane
+constexpr int tilesPerWord = 64;
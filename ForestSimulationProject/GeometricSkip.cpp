@@ -0,0 +1,88 @@
+#include "GeometricSkip.h"
+#include <cmath>
+
+namespace
+{
+
+const double ln2 = 0.693147180559945309417;
+
+//ln x for x > 0 from frexp (exact) and + - * / only: x = m * 2^e, and ln m = 2 atanh((m - 1) / (m + 1)) by its series.
+//Those operations are correctly rounded on every IEEE platform, library log is not
+double portableLog(double x)
+{
+	int exponent;
+	double m = std::frexp(x, &exponent);
+	if (m < 0.70710678118654752)
+	{
+		m *= 2;
+		--exponent;
+	}
+
+	//|z| < 0.172, so 20 terms are far past double precision
+	double z = (m - 1) / (m + 1);
+	double z2 = z * z;
+	double term = z, sum = 0;
+	for (int n = 1; n < 40; n += 2)
+	{
+		sum += term / n;
+		term *= z2;
+	}
+
+	return 2 * sum + exponent * ln2;
+}
+
+//ln(1 - p) for p <= 1/16 by its series, without the rounding of 1 - p that would lose most digits of a tiny p
+double portableLogFailure(double p)
+{
+	double term = p, sum = 0;
+	for (int n = 1; n < 20; ++n)
+	{
+		sum += term / n;
+		term *= p;
+	}
+
+	return -sum;
+}
+
+//high 64 bits of a * b, from 32 bit halves
+std::uint64_t mulHigh(std::uint64_t a, std::uint64_t b)
+{
+	std::uint64_t aLow = a & 0xFFFFFFFFu, aHigh = a >> 32;
+	std::uint64_t bLow = b & 0xFFFFFFFFu, bHigh = b >> 32;
+	std::uint64_t low = aLow * bLow;
+	std::uint64_t middle1 = aHigh * bLow + (low >> 32);
+	std::uint64_t middle2 = aLow * bHigh + (middle1 & 0xFFFFFFFFu);
+	return aHigh * bHigh + (middle1 >> 32) + (middle2 >> 32);
+}
+
+}
+
+GeometricSkip::GeometricSkip(std::uint64_t threshold) : threshold(threshold)
+{
+	if (isSparse())
+		logFailure = portableLogFailure(std::ldexp(double(threshold), -64));
+}
+
+int GeometricSkip::operator()(std::uint64_t draw) const
+{
+	//uniform u in (0, 1], the gap is floor(ln u / ln(1 - p)): P(gap >= g) = P(u <= (1 - p)^g) = (1 - p)^g
+	double u = std::ldexp(double((draw >> 11) + 1), -53);
+	double gap = portableLog(u) / logFailure;
+	return gap < maxGap ? int(gap) : maxGap;
+}
+
+std::uint64_t GeometricSkip::skipBound(int count) const
+{
+	if (!isSparse())
+		return 0;
+
+	//P(gap >= count) = (1 - p)^count. Library exp is fine here, the margin is far wider than its rounding
+	double bound = std::exp(count * logFailure) * (1 - 1e-9);
+	return std::uint64_t(std::ldexp(bound, 64));
+}
+
+bool GeometricSkip::accept(std::uint64_t draw, std::uint64_t tileThreshold) const
+{
+	//draw scaled to a uniform integer in [0, threshold)
+	return mulHigh(draw, threshold) < tileThreshold;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+//Sampler for a sparse Bernoulli process over a row of tiles: instead of one draw per tile, one raw 64 bit draw gives the
+//number of tiles to skip before the next success (a geometric gap), for a success probability p = threshold / 2^64.
+//With p an upper bound on the per tile probabilities, accept() thins the successes down to each tile's own probability.
+//The gap uses a logarithm built from + - * / only (like PoissonTable's exp), so the gaps are the same with every compiler.
+class GeometricSkip
+{
+public:
+	GeometricSkip() = default;
+	explicit GeometricSkip(std::uint64_t threshold);
+
+	//number of failures before the next success, capped at maxGap
+	int operator()(std::uint64_t draw) const;
+
+	//draws below skipBound(count) give a gap of at least count, so a row of count tiles is passed over with one compare.
+	//It sits a hair (1e-9 relative) below the exact bound, so rounding never decides it; draws above it need operator()
+	std::uint64_t skipBound(int count) const;
+
+	//thinning: true with probability tileThreshold / threshold for a tileThreshold <= threshold
+	bool accept(std::uint64_t draw, std::uint64_t tileThreshold) const;
+
+	//skipping only pays for small probabilities, otherwise a draw per tile is cheaper
+	bool isSparse() const { return threshold > 0 && threshold <= (~std::uint64_t(0) >> sparseBits); }
+
+	static constexpr int maxGap = 1 << 30;
+
+private:
+	static constexpr int sparseBits = 4; //p <= 1/16
+
+	std::uint64_t threshold = 0;
+	double logFailure = 0; //ln(1 - p)
+};
@@ -0,0 +1,53 @@
+#include "PoissonTable.h"
+#include "CounterRandom.h"
+
+namespace
+{
+
+//e^x for x <= 0 from + - * / only: a Taylor series on x / 2^10, squared back up 10 times.
+//Those operations are correctly rounded on every IEEE platform, library exp is not
+double portableExp(double x)
+{
+	double y = x / 1024;
+	double term = 1, sum = 1;
+	for (int n = 1; n < 20; ++n)
+	{
+		term *= y / n;
+		sum += term;
+	}
+
+	for (int k = 0; k < 10; ++k)
+		sum *= sum;
+
+	return sum;
+}
+
+}
+
+PoissonTable::PoissonTable(double mean) : mean(mean)
+{
+	//P(X = k) = P(X = k - 1) * mean / k, accumulated until the terms, which fall off fast past the mean, are negligible.
+	//That is some 10 standard deviations past the mean; the cap on k only guards the loop and is far beyond it for every mean,
+	//including the several hundred of the event engine's tables for many days at once
+	const double negligible = 1.0 / (std::uint64_t(1) << 60);
+	double probability = portableExp(-mean);
+	double cumulative = probability;
+
+	cdf.clear();
+	for (int k = 1; (k <= mean || probability > negligible) && k < 2 * mean + 512; ++k)
+	{
+		cdf.push_back(probabilityThreshold(cumulative));
+		probability *= mean / k;
+		cumulative += probability;
+	}
+	cdf.push_back(~std::uint64_t(0));
+
+	int k = 0;
+	for (int g = 0; g < (1 << guideBits); ++g)
+	{
+		std::uint64_t start = std::uint64_t(g) << (64 - guideBits);
+		while (cdf[k] < start)
+			++k;
+		guide[g] = k;
+	}
+}
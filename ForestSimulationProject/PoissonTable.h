@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+//Poisson sampler that turns one raw 64 bit draw into a sample by inverse CDF lookup in a table built once for a fixed mean.
+//A guide table indexed by the top bits of the draw starts the search next to the answer, so a sample is one or two compares.
+//The table is built with + - * / only (no library exp), so the samples are the same with every compiler and standard library.
+class PoissonTable
+{
+public:
+	PoissonTable() = default;
+	explicit PoissonTable(double mean);
+
+	//the smallest k with draw <= cdf[k]
+	int operator()(std::uint64_t draw) const
+	{
+		int k = guide[draw >> (64 - guideBits)];
+		while (draw > cdf[k])
+			++k;
+		return k;
+	}
+
+	double getMean() const { return mean; }
+
+	//the largest value a draw can give
+	int getMaxValue() const { return int(cdf.size()) - 1; }
+
+private:
+	static constexpr int guideBits = 8;
+
+	double mean = 0;
+
+	//cdf[k] = P(X <= k) * 2^64. The last entry is ~0, so the negligible tail past it folds into the last value
+	std::vector<std::uint64_t> cdf = { ~std::uint64_t(0) };
+
+	//guide[g] = the smallest k with cdf[k] >= g * 2^(64 - guideBits)
+	std::vector<int> guide = std::vector<int>(1 << guideBits, 0);
+};
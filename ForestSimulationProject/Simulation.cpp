@@ -0,0 +1,690 @@
+#include "Simulation.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <chrono>
+
+std::mutex console_mutex;
+
+std::uint64_t add_saturate(std::uint64_t a, std::uint64_t b) {
+	return (a + b < a) ? ~std::uint64_t(0) : a + b;
+};
+
+//Convert a volume parameter to fixed point thousandths. Volumes only exist in whole thousandths, so anything finer is a configuration error.
+int to_fixed_volume(double volume, const char * name) {
+	double scaled = volume * volumeScale;
+	int fixed = int(std::lround(scaled));
+	if (std::fabs(scaled - fixed) > 1e-6) {
+		std::cout << name << " = " << volume << " is not a whole number of thousandths" << std::endl;
+		exit(-1);
+	};
+	return fixed;
+};
+
+void prepare_simulation_config(SimulationConfig & config) {
+	//volume parameters in fixed point
+	config.raking_amount_fixed = to_fixed_volume(config.raking_amount, "raking_amount");
+	config.nutrient_depletion_rate_fixed = to_fixed_volume(config.nutrient_depletion_rate, "nutrient_depletion_rate");
+
+	for (int s = 0; s < 4; ++s) {
+		const SeasonParameters & season = config.seasons[s];
+
+		//Poisson sampler for the season's leaf increment. Multiply by 1000 to generate integer thousandths of leaf volume.
+		double leaf_fall_rate = 1000 * (config.average_leaf_fall + season.seasonal_leaf_fall_inc);
+		double leaf_growth_rate = 1000 * (config.average_leaf_growth + season.seasonal_leaf_growth_inc);
+		config.leaf_increment_tables[s] = PoissonTable(leaf_fall_rate + leaf_growth_rate);
+
+		//Fire probabilities of the season
+		FireCheckParams & params = config.fire_check_params[s];
+		params.season = probabilityThreshold(config.p_fire_season_base_rate * season.p_fire_season_factor);
+		params.leafUnit = std::min(probabilityThreshold(config.leaf_fire_contribution / volumeScale), ~std::uint64_t(0) / volumeScale);
+		//Lookup table by number of burning edge and corner neighbors
+		for (int e = 0; e <= 4; ++e) {
+			for (int c = 0; c <= 4; ++c) {
+				std::uint64_t edge = probabilityThreshold(e * config.p_fire_neighbor_e);
+				std::uint64_t corner = probabilityThreshold(c * config.p_fire_neighbor_c);
+				params.neighbors[e][c] = add_saturate(edge, corner);
+			};
+		};
+
+		//Largest background ignition threshold: a full leaf volume and no burning neighbors
+		config.ignition_skips[s] = GeometricSkip(add_saturate(add_saturate(params.season, volumeScale * params.leafUnit), params.neighbors[0][0]));
+	};
+
+	config.fire_duration_table = PoissonTable(config.average_fire_duration);
+
+	//Leaf increments of whole quiet intervals for the event engine. An interval stays within one season.
+	if (config.event_engine) {
+		double max_rate = 0;
+		for (int s = 0; s < 4; ++s) {
+			max_rate = std::max(max_rate, config.leaf_increment_tables[s].getMean());
+		};
+		config.quiet_interval_max = std::max(1, std::min(config.season_length, int(600 / std::max(max_rate, 1.0))));
+		config.quiet_leaf_tables.clear();
+		for (int s = 0; s < 4; ++s) {
+			for (int days = 0; days <= config.quiet_interval_max; ++days) {
+				config.quiet_leaf_tables.push_back(PoissonTable(config.leaf_increment_tables[s].getMean() * days));
+			};
+		};
+	};
+
+	//seed the generator
+	config.generator.seed(config.seed);
+};
+
+RowScratch::RowScratch(const SimulationConfig & config, int words_per_row) {
+	leaf_increments.resize(config.cols);
+	leaf_draws.resize(config.cols);
+	neighbor_counts.resize(words_per_row);
+	fire_draws.resize(config.cols);
+	ignitions.resize(words_per_row);
+};
+
+SimulationState::SimulationState(const SimulationConfig & config)
+	: board(config.rows, config.cols, config.nutrient_depletion_rate_fixed), scratch(config, board.getWordsPerRow()), fire_calendar(std::max(config.fire_duration_table.getMaxValue(), 2)) {
+	if (config.event_engine) {
+		tile_days.resize(board.getNumTiles());
+		crossings.resize(board.getNumTiles());
+	};
+};
+
+int season_of_day(const SimulationConfig & config, int t) {
+	return (t / config.season_length) % 4;
+};
+
+bool is_raking_day(const SimulationConfig & config, int t) {
+	return t > 20 && t % config.raking_frequency == 0;
+};
+
+//Word w of a fire state row shifted so that every tile sees its neighbor at column offset col_offset (-1, 0 or 1).
+//Bits shifted in across the row ends come from the zero ghost words.
+std::uint64_t shifted_fire_word(const std::uint64_t * row, int w, int col_offset) {
+	if (col_offset < 0) {
+		return (row[w] << 1) | (row[w - 1] >> (tilesPerWord - 1));
+	}
+	else if (col_offset > 0) {
+		return (row[w] >> 1) | (row[w + 1] << (tilesPerWord - 1));
+	}
+	else {
+		return row[w];
+	};
+};
+
+//Bit sliced sum of four one bit inputs per tile into a three bit count (max 4).
+void add_four_bits(std::uint64_t a, std::uint64_t b, std::uint64_t c, std::uint64_t d, std::uint64_t count[3]) {
+	std::uint64_t sum_ab = a ^ b, carry_ab = a & b;
+	std::uint64_t sum_cd = c ^ d, carry_cd = c & d;
+	std::uint64_t carry_sum = sum_ab & sum_cd;
+	count[0] = sum_ab ^ sum_cd;
+	count[1] = carry_ab ^ carry_cd ^ carry_sum;
+	count[2] = (carry_ab & carry_cd) | (carry_ab & carry_sum) | (carry_cd & carry_sum);
+};
+
+//Count burning edge and corner neighbors for the 64 tiles of word w in row i, using shifted whole word adds over the fixed stencil.
+//Neighbors outside the board are in the ghost border and never burn.
+NeighborFireCounts count_fire_neighbors(ForestBoard & board, int i, int w) {
+	std::uint64_t edge[4], corner[4];
+	for (int k = 0; k < 4; ++k) {
+		edge[k] = shifted_fire_word(board.onFireRow(i + edgeStencil[k].row), w, edgeStencil[k].col);
+		corner[k] = shifted_fire_word(board.onFireRow(i + cornerStencil[k].row), w, cornerStencil[k].col);
+	};
+
+	NeighborFireCounts counts;
+	add_four_bits(edge[0], edge[1], edge[2], edge[3], counts.edge);
+	add_four_bits(corner[0], corner[1], corner[2], corner[3], counts.corner);
+	return counts;
+};
+
+//Function to determine if an absorbing state has been reached. Absorbing states: leaf volume of entire forest = 0 or leaf volume of entire forest = MAX.
+//Uses the empty/saturated tile counts the board keeps up to date, so this is O(1) per day.
+bool is_absorbing_state(ForestBoard & board, int trial, int t) {
+	//If every block is empty or every block is full, return true.
+	if (board.getEmptyTiles() == board.getNumTiles()) {
+		std::lock_guard<std::mutex> lock(console_mutex);
+		std::cout << "Reaches absorbing state barren trial : " << trial << " t : " << t << std::endl;
+		return true;
+	}
+	else if (board.getSaturatedTiles() == board.getNumTiles()) {
+		std::lock_guard<std::mutex> lock(console_mutex);
+		std::cout << "Reaches absorbing state overgrowth trial : " << trial << " t : " << t << std::endl;
+		return true;
+	}
+	//Else return false
+	else {
+		return false;
+	};
+};
+
+//Start and end the fires of row i scheduled for day time (events, sorted by tile). A start turns the tile's leaves into nutrients.
+void apply_fire_events(const SimulationConfig & config, ForestBoard & board, const std::vector<FireEvent> & events, int time, int i, LeafTotalsDelta & delta) {
+	int cols = config.cols;
+	auto event = std::lower_bound(events.begin(), events.end(), i * cols, [](const FireEvent & e, int tile) { return e.tile < tile; });
+	RowSpan<volume_t> leaves = board.leafRowUntracked(i);
+	for (; event != events.end() && event->tile < (i + 1) * cols; ++event) {
+		int j = event->tile - i * cols;
+		if (event->start) {
+			int leaf = leaves[j];
+			board.setNutrientVolume(event->tile, time, std::min(board.nutrientVolume(event->tile, time) + leaf, volumeScale));
+			leaves[j] = 0;
+			delta.emptyTiles += int(leaf != 0);
+			delta.saturatedTiles -= int(leaf == volumeScale);
+			delta.leafVolume -= leaf;
+		};
+		board.setOnFire(i, j, event->start);
+	};
+};
+
+//Whether all tiles of word w of row i are full of leaves.
+bool word_is_saturated(ForestBoard & board, int i, int w) {
+	RowSpan<const volume_t> leaves = board.leafRow(i);
+	int last = std::min((w + 1) * tilesPerWord, leaves.size());
+	for (int j = w * tilesPerWord; j < last; ++j) {
+		if (leaves[j] != volumeScale) {
+			return false;
+		};
+	};
+	return true;
+};
+
+//Update leaves, then rake and start/end scheduled fires in row i (Does not include new forest fire generations).
+//Nutrients deplete lazily, see ForestBoard::nutrientVolume.
+//Leaves only grow between rakings, so on days without raking the words of the row that are all full stay full and are skipped,
+//draws included (every draw is per tile, so the other tiles get the same ones).
+//Returns the change in the board's leaf totals, for the caller to add to the board.
+LeafTotalsDelta leaf_morning_update_row(const SimulationConfig & config, SimulationState & state, RowScratch & scratch, const std::vector<FireEvent> & events,
+	int trial, int time, int i, bool raking_required) {
+	int cols = config.cols;
+	int words = state.board.getWordsPerRow();
+	ForestBoard & board = state.board;
+	const PoissonTable & leaf_increment_table = config.leaf_increment_tables[state.season];
+
+	LeafMorningParams params;
+	params.rakeAmount = raking_required ? config.raking_amount_fixed : 0;
+
+	LeafTotalsDelta delta;
+	for (int first_word = 0; first_word < words;) {
+		//next run of words that can change
+		if (!raking_required && board.isSaturatedWord(i, first_word)) {
+			++first_word;
+			continue;
+		};
+		int last_word = first_word + 1;
+		while (last_word < words && (raking_required || !board.isSaturatedWord(i, last_word))) {
+			++last_word;
+		};
+		int first = first_word * tilesPerWord, last = std::min(last_word * tilesPerWord, cols);
+
+		//Draw new leaf fall and growth for every forest block of the run, one raw draw each. The kernel ignores them for blocks under fire.
+		config.generator.fill(scratch.leaf_draws.data() + first, trial, time, i * cols + first, last - first, RandomPurpose::LeafIncrement);
+		for (int j = first; j < last; ++j) {
+			scratch.leaf_increments[j] = volume_t(leaf_increment_table(scratch.leaf_draws[j]));
+		};
+
+		LeafMorningRow row;
+		row.leaves = board.leafRowUntracked(i).begin() + first;
+		row.onFire = board.onFireRow(i) + first_word;
+		row.leafIncrements = scratch.leaf_increments.data() + first;
+		row.count = last - first;
+
+		//Vectorized leaf update and morning update of the run
+		LeafTotalsDelta run = leaf_morning_row(row, params);
+		delta.emptyTiles += run.emptyTiles;
+		delta.saturatedTiles += run.saturatedTiles;
+		delta.leafVolume += run.leafVolume;
+		first_word = last_word;
+	};
+
+	//The few tiles whose fire state changes today, then which words are full now. The kernel's writes don't clear the flags,
+	//so a raking day sets every word's flag again
+	apply_fire_events(config, board, events, time, i, delta);
+	for (int w = 0; w < words; ++w) {
+		if (raking_required || !board.isSaturatedWord(i, w)) {
+			board.setSaturatedWord(i, w, word_is_saturated(board, i, w));
+		};
+	};
+	return delta;
+};
+
+//Schedule tile (i, j) to catch fire the next day, with a drawn duration of fire. The fire is put out on the morning of
+//day time + duration, but burns for at least the day it starts.
+void ignite_tile(const SimulationConfig & config, RowScratch & scratch, int trial, int time, int i, int j) {
+	int tile = i * config.cols + j;
+	int t_fire = config.fire_duration_table(config.generator(trial, time, tile, RandomPurpose::FireDuration));
+	scratch.new_fire_events.push_back({ time + 1, { tile, true } });
+	scratch.new_fire_events.push_back({ time + std::max(t_fire, 2), { tile, false } });
+};
+
+//Retire today's events and move the fires scheduled during the day from scratch onto the calendar.
+void schedule_new_fires(SimulationState & state, RowScratch & scratch) {
+	for (const ScheduledFireEvent & scheduled : scratch.new_fire_events) {
+		state.fire_calendar.schedule(scheduled.day, scheduled.event);
+	};
+	scratch.new_fire_events.clear();
+};
+
+//Check new fire generations in row i, a row with no fire in or next to it. Every tile's probability is then at most the season's
+//skip bound, so instead of a draw per tile the check jumps geometric gaps straight to the candidate tiles, about one per 1 / bound
+//tiles, and keeps each candidate with probability (its threshold / bound). Each tile still ignites with exactly its own probability.
+//Every gap draw is addressed by the tile its search starts at, every keep draw by its candidate, so no two draws share a counter.
+void check_background_fire_row(const SimulationConfig & config, SimulationState & state, RowScratch & scratch, int trial, int time, int i) {
+	int cols = config.cols;
+	ForestBoard & board = state.board;
+	const GeometricSkip & skip = config.ignition_skips[state.season];
+	const FireCheckParams & params = config.fire_check_params[state.season];
+	RowSpan<const volume_t> leaves = board.leafRow(i);
+
+	for (int j = 0; j < cols; ++j) {
+		j += skip(config.generator(trial, time, i * cols + j, RandomPurpose::IgnitionSkip));
+		if (j >= cols) {
+			break;
+		};
+
+		std::uint64_t threshold = add_saturate(add_saturate(params.season, leaves[j] * params.leafUnit), params.neighbors[0][0]);
+		if (skip.accept(config.generator(trial, time, i * cols + j, RandomPurpose::Ignition), threshold)) {
+			ignite_tile(config, scratch, trial, time, i, j);
+		};
+	};
+};
+
+//Check new fire generations in row i. Needs rows i - 1, i and i + 1 to have had their morning update.
+void check_new_fire_row(const SimulationConfig & config, SimulationState & state, RowScratch & scratch, int trial, int time, int i) {
+	int cols = config.cols;
+	ForestBoard & board = state.board;
+	int words = board.getWordsPerRow();
+
+	//Fires are rare and local, rows with no fire in or next to them only have background ignitions
+	bool near_fire = board.burningTiles(i - 1) + board.burningTiles(i) + board.burningTiles(i + 1) > 0;
+	if (!near_fire && config.ignition_skips[state.season].isSparse()) {
+		check_background_fire_row(config, state, scratch, trial, time, i);
+		return;
+	};
+
+	//Count burning neighbors 64 tiles at a time, only for rows with a fire near them
+	if (near_fire) {
+		for (int w = 0; w < words; ++w) {
+			scratch.neighbor_counts[w] = count_fire_neighbors(board, i, w);
+		};
+		scratch.neighbor_counts_zero = false;
+	}
+	else if (!scratch.neighbor_counts_zero) {
+		std::fill(scratch.neighbor_counts.begin(), scratch.neighbor_counts.end(), NeighborFireCounts());
+		scratch.neighbor_counts_zero = true;
+	};
+
+	//One draw per tile for the whole row, then every tile not under fire is checked against its fire probability
+	config.generator.fill(scratch.fire_draws.data(), trial, time, i * cols, cols, RandomPurpose::Ignition);
+
+	FireCheckRow row;
+	row.leaves = board.leafRow(i).begin();
+	row.onFire = board.onFireRow(i);
+	row.neighbors = scratch.neighbor_counts.data();
+	row.draws = scratch.fire_draws.data();
+	row.ignitions = scratch.ignitions.data();
+	row.count = cols;
+	fire_check_row(row, config.fire_check_params[state.season]);
+
+	//If fire will start, update to start next day, generate and update duration of fire.
+	for (int w = 0; w < words; ++w) {
+		std::uint64_t bits = scratch.ignitions[w];
+		for (int j = w * tilesPerWord; bits != 0; ++j, bits >>= 1) {
+			if (bits & 1) {
+				ignite_tile(config, scratch, trial, time, i, j);
+			};
+		};
+	};
+};
+
+//Simulate one day: leaf update, raking, fire starts/ends and new fire generations, fused into one row by row pass.
+//Gives the same day as running each of those steps over the whole board in turn: row i only depends on rows i - 1 .. i + 1,
+//so the fire check runs one row behind the leaf and morning updates, once the row below it has had its fires started or ended.
+void step(const SimulationConfig & config, SimulationState & state, int trial, int time) {
+	//Checking of raking is required.
+	bool raking_required = is_raking_day(config, time);
+	const std::vector<FireEvent> & events = state.fire_calendar.eventsOf(time);
+
+	for (int i = 0; i <= config.rows; ++i) {
+		if (i < config.rows) {
+			LeafTotalsDelta delta = leaf_morning_update_row(config, state, state.scratch, events, trial, time, i, raking_required);
+			state.board.addLeafTotals(delta.emptyTiles, delta.saturatedTiles, delta.leafVolume);
+		};
+		if (i > 0) {
+			check_new_fire_row(config, state, state.scratch, trial, time, i - 1);
+		};
+	};
+
+	state.fire_calendar.finishDay(time);
+	schedule_new_fires(state, state.scratch);
+};
+
+//Whether row r of band [first, last) can have its fire check before the other bands finish their updates:
+//its neighbor rows r - 1 and r + 1 are in the band or past the board edge.
+bool band_row_is_inner(int r, int first, int last, int rows) {
+	return (r > first || first == 0) && (r < last - 1 || last == rows);
+};
+
+void step_banded(const SimulationConfig & config, SimulationState & state, WorkStealingPool & band_pool, int trial, int time) {
+	//Checking of raking is required.
+	bool raking_required = is_raking_day(config, time);
+
+	int rows = config.rows;
+	int bands = std::min(band_pool.getNumWorkers(), rows);
+	int band_rows = (rows + bands - 1) / bands;
+	while (int(state.band_scratch.size()) < bands) {
+		state.band_scratch.emplace_back(config, state.board.getWordsPerRow());
+	};
+	std::vector<LeafTotalsDelta> deltas(bands);
+	const std::vector<FireEvent> & events = state.fire_calendar.eventsOf(time);
+
+	//Leaf and morning updates of every band, with the fire checks that only need rows of the band
+	band_pool.run(bands, [&](int, int band) {
+		int first = band * band_rows, last = std::min(first + band_rows, rows);
+		RowScratch & scratch = state.band_scratch[band];
+		LeafTotalsDelta & total = deltas[band];
+		for (int i = first; i < last; ++i) {
+			LeafTotalsDelta delta = leaf_morning_update_row(config, state, scratch, events, trial, time, i, raking_required);
+			total.emptyTiles += delta.emptyTiles;
+			total.saturatedTiles += delta.saturatedTiles;
+			total.leafVolume += delta.leafVolume;
+			if (i > first && band_row_is_inner(i - 1, first, last, rows)) {
+				check_new_fire_row(config, state, scratch, trial, time, i - 1);
+			};
+		};
+		if (last > first && last == rows && band_row_is_inner(last - 1, first, last, rows)) {
+			check_new_fire_row(config, state, scratch, trial, time, last - 1);
+		};
+	});
+
+	for (const LeafTotalsDelta & delta : deltas) {
+		state.board.addLeafTotals(delta.emptyTiles, delta.saturatedTiles, delta.leafVolume);
+	};
+
+	//Fire checks of the rows next to another band, now that the halo rows are updated
+	band_pool.run(bands, [&](int, int band) {
+		int first = band * band_rows, last = std::min(first + band_rows, rows);
+		RowScratch & scratch = state.band_scratch[band];
+		if (last > first && !band_row_is_inner(first, first, last, rows)) {
+			check_new_fire_row(config, state, scratch, trial, time, first);
+		};
+		if (last - 1 > first && !band_row_is_inner(last - 1, first, last, rows)) {
+			check_new_fire_row(config, state, scratch, trial, time, last - 1);
+		};
+	});
+
+	state.fire_calendar.finishDay(time);
+	for (int band = 0; band < bands; ++band) {
+		schedule_new_fires(state, state.band_scratch[band]);
+	};
+};
+
+//Number of tiles on fire, from the board's per row counts
+int count_burning_tiles(ForestBoard & board) {
+	int burning = 0;
+	for (int i = 0; i < board.getHeight(); ++i) {
+		burning += board.burningTiles(i);
+	};
+	return burning;
+};
+
+//One line of a replay trace: the board totals at the end of day t
+void print_trace_day(std::ostream & trace, SimulationState & state, int t) {
+	ForestBoard & board = state.board;
+	trace << "day " << t << " season " << state.season
+		<< " leaf " << double(board.getTotalLeafVolume()) / volumeScale
+		<< " empty " << board.getEmptyTiles()
+		<< " saturated " << board.getSaturatedTiles()
+		<< " burning " << count_burning_tiles(board) << std::endl;
+};
+
+//Bring a tile of a quiet interval up to day d: the leaf fall and growth of all its days since its last update as one Poisson draw
+//(the cap at full leaves the same volume whether it is applied once or every day, as no day takes leaves away).
+//Records where a tile becomes full, for saturation_day().
+void advance_quiet_tile(const SimulationConfig & config, SimulationState & state, int tile, int d, std::uint64_t draw) {
+	int & last_day = state.tile_days[tile];
+	int days = d - last_day;
+	if (days == 0) {
+		return;
+	};
+
+	ForestBoard & board = state.board;
+	int leaf = board.leafVolume(tile);
+	int arrivals = config.quiet_leaf_tables[state.season * (config.quiet_interval_max + 1) + days](draw);
+	if (leaf < volumeScale && leaf + arrivals >= volumeScale) {
+		state.crossings[tile] = { last_day, d, volumeScale - leaf, arrivals };
+	};
+	board.setLeafVolume(tile, std::min(leaf + arrivals, volumeScale));
+	last_day = d;
+};
+
+//Bring every tile of a quiet interval up to day d, a row of draws at a time.
+void advance_quiet_tiles(const SimulationConfig & config, SimulationState & state, int trial, int d) {
+	int cols = config.cols;
+	std::vector<std::uint64_t> & draws = state.scratch.leaf_draws;
+	for (int i = 0; i < config.rows; ++i) {
+		config.generator.fill(draws.data(), trial, d, i * cols, cols, RandomPurpose::LeafIncrement);
+		for (int j = 0; j < cols; ++j) {
+			advance_quiet_tile(config, state, i * cols + j, d, draws[j]);
+		};
+	};
+};
+
+//Day a tile that is full now became full, in a quiet interval that started after day s. Given their total, the arrivals of the days
+//of its last draw are spread uniformly over those days, so each arrival gets a uniform day and the tile is full on the day the need-th lands.
+int saturation_day(const SimulationConfig & config, SimulationState & state, int trial, int tile, int s) {
+	const SaturationCrossing & crossing = state.crossings[tile];
+	if (crossing.last_day <= s) {
+		return s;
+	};
+
+	int days = crossing.last_day - crossing.first_day;
+	std::vector<int> per_day(days, 0);
+	for (int a = 0; a < crossing.arrivals; ++a) {
+		std::uint64_t draw = config.generator(trial, crossing.last_day, tile, RandomPurpose(std::uint32_t(RandomPurpose::ArrivalDays) + a));
+		++per_day[std::min(int(std::ldexp(double(draw >> 11), -53) * days), days - 1)];
+	};
+
+	int arrived = 0;
+	for (int k = 0; k < days; ++k) {
+		arrived += per_day[k];
+		if (arrived >= crossing.need) {
+			return crossing.first_day + 1 + k;
+		};
+	};
+	return crossing.last_day;
+};
+
+//Day the board became full in a quiet interval that started after day s, with every tile full now.
+int board_saturation_day(const SimulationConfig & config, SimulationState & state, int trial, int s) {
+	int day = s;
+	for (int tile = 0; tile < state.board.getNumTiles(); ++tile) {
+		day = std::max(day, saturation_day(config, state, trial, tile, s));
+	};
+	return day;
+};
+
+//Simulate the quiet days s + 1 .. e of a trial, with no fire burning or scheduled after day s. e is the next raking day, the last day
+//of the season, the last day of the trial or the longest interval, whichever comes first, or the day of the first ignition before it.
+//The background ignitions of the interval are one geometric skip over its (day, tile) positions in time order, like
+//check_background_fire_row() over a row. The board can't become barren before e, as no leaves are taken away before the raking on e,
+//and it becomes full on the day its last tile does. Returns the next day to simulate, or with absorbing_state set, the day after it was reached.
+int run_quiet_interval(const SimulationConfig & config, SimulationState & state, int trial, int s, bool & absorbing_state, std::ostream * trace) {
+	ForestBoard & board = state.board;
+	int cols = config.cols;
+	int tiles = board.getNumTiles();
+	state.season = season_of_day(config, s + 1);
+
+	int season_end = ((s + 1) / config.season_length + 1) * config.season_length - 1;
+	int first_raking = std::max(s + 1, 21);
+	int next_raking = (first_raking + config.raking_frequency - 1) / config.raking_frequency * config.raking_frequency;
+	int e = std::min({ season_end, next_raking, config.T - 1, s + config.quiet_interval_max });
+	//Only the crossings of this interval count: a tile that was full at its start, whether it filled on a stepped day or in
+	//an earlier interval, was full from day s on
+	std::fill(state.tile_days.begin(), state.tile_days.end(), s);
+	std::fill(state.crossings.begin(), state.crossings.end(), SaturationCrossing());
+
+	const GeometricSkip & skip = config.ignition_skips[state.season];
+	const FireCheckParams & params = config.fire_check_params[state.season];
+	int end_day = e;
+	bool at_end_day = false;   //every tile is up to date with end_day, and raked if it is a raking day
+	int saturated_day = -1;    //the day the board became full, if it did before the raking of e
+
+	//Bring every tile up to end_day. The fire checks of a raking day see the raked leaves, so e is raked before its candidates.
+	auto finish_interval = [&]() {
+		advance_quiet_tiles(config, state, trial, end_day);
+		if (board.getSaturatedTiles() == tiles) {
+			saturated_day = board_saturation_day(config, state, trial, s);
+		};
+		if (is_raking_day(config, end_day)) {
+			for (int tile = 0; tile < tiles; ++tile) {
+				board.setLeafVolume(tile, std::max(int(board.leafVolume(tile)) - config.raking_amount_fixed, 0));
+			};
+			//Raked on its last day, the board is only full after the raking if nothing was raked
+			if (saturated_day == end_day && board.getSaturatedTiles() != tiles) {
+				saturated_day = -1;
+			};
+		};
+		at_end_day = true;
+	};
+
+	std::int64_t positions = std::int64_t(e - s) * tiles;
+	for (std::int64_t position = 0; position < positions; ++position) {
+		int day = s + 1 + int(position / tiles);
+		int gap = skip(config.generator(trial, day, int(position % tiles), RandomPurpose::IgnitionSkip));
+		position += gap;
+		if (gap == GeometricSkip::maxGap) {
+			//No candidate up to there, and the gaps are memoryless, so the search starts over from there
+			--position;
+			continue;
+		};
+		if (position >= positions) {
+			break;
+		};
+
+		day = s + 1 + int(position / tiles);
+		int tile = int(position % tiles);
+		if (day > end_day) {
+			break;
+		};
+		if (day == e && !at_end_day) {
+			finish_interval();
+		}
+		else if (!at_end_day) {
+			advance_quiet_tile(config, state, tile, day, config.generator(trial, day, tile, RandomPurpose::LeafIncrement));
+		};
+
+		std::uint64_t threshold = add_saturate(add_saturate(params.season, board.leafVolume(tile) * params.leafUnit), params.neighbors[0][0]);
+		if (skip.accept(config.generator(trial, day, tile, RandomPurpose::Ignition), threshold)) {
+			ignite_tile(config, state.scratch, trial, day, tile / cols, tile % cols);
+			//The rest of the day's candidates are still checked, the fire starts tomorrow
+			end_day = day;
+		};
+	};
+
+	if (!at_end_day) {
+		finish_interval();
+	};
+	schedule_new_fires(state, state.scratch);
+
+	if (saturated_day >= 0) {
+		std::lock_guard<std::mutex> lock(console_mutex);
+		std::cout << "Reaches absorbing state overgrowth trial : " << trial << " t : " << saturated_day << std::endl;
+		absorbing_state = true;
+		return saturated_day + 1;
+	};
+	absorbing_state = is_absorbing_state(board, trial, end_day);
+	if (trace) {
+		print_trace_day(*trace, state, end_day);
+	};
+	return end_day + 1;
+};
+
+int run_trial_events(const SimulationConfig & config, SimulationState & state, int trial, bool & absorbing_state, std::ostream * trace, WorkStealingPool * band_pool) {
+	//Every trial starts in spring on a cleared board
+	state.board.reset();
+	state.fire_calendar.clear();
+	state.season = 0;
+	std::fill(state.tile_days.begin(), state.tile_days.end(), 0);
+	std::fill(state.crossings.begin(), state.crossings.end(), SaturationCrossing());
+
+	//Day 0 is stepped, so every quiet interval starts from a board that is up to date and not in an absorbing state
+	absorbing_state = false;
+	int t = 0;
+	while (t < config.T && !absorbing_state) {
+		state.season = season_of_day(config, t);
+		bool quiet = t > 0 && state.fire_calendar.isEmpty() && count_burning_tiles(state.board) == 0 && config.ignition_skips[state.season].isSparse();
+		if (quiet) {
+			t = run_quiet_interval(config, state, trial, t - 1, absorbing_state, trace);
+			continue;
+		};
+
+		if (band_pool) {
+			step_banded(config, state, *band_pool, trial, t);
+		}
+		else {
+			step(config, state, trial, t);
+		};
+		absorbing_state = is_absorbing_state(state.board, trial, t);
+
+		if (trace) {
+			print_trace_day(*trace, state, t);
+		};
+		++t;
+	};
+
+	return t;
+};
+
+int run_trial(const SimulationConfig & config, SimulationState & state, int trial, bool & absorbing_state, std::ostream * trace, WorkStealingPool * band_pool) {
+	if (config.event_engine) {
+		return run_trial_events(config, state, trial, absorbing_state, trace, band_pool);
+	};
+
+	//Every trial starts in spring on a cleared board
+	state.board.reset();
+	state.fire_calendar.clear();
+	state.season = 0;
+
+	//Perform simulation untill max simulation time is reached or an absorbing state is reached
+	absorbing_state = false;
+	int t = 0;                //Variable to keep track of days.
+	int season_counter = 0;   //Variable to track current season.
+	while (t < config.T && !absorbing_state) {
+		//Determine current season
+		if (season_counter == config.season_length) {
+			++state.season;
+			if (state.season > 3) {
+				state.season = 0;
+			}
+			season_counter = 0;
+		}
+
+		//Update leaf volumes, rake leaves if required, start/end scheduled fires and check if new fires will start
+		if (band_pool) {
+			step_banded(config, state, *band_pool, trial, t);
+		}
+		else {
+			step(config, state, trial, t);
+		};
+		//Check if absorbing states are reached
+		absorbing_state = is_absorbing_state(state.board, trial, t);
+
+		if (trace) {
+			print_trace_day(*trace, state, t);
+		};
+
+		//Increment time counters
+		++t;
+		++season_counter;
+
+#ifdef VISUALIZE
+		//visualize
+		state.board.drawBoard();
+		state.board.display();
+		//std::this_thread::sleep_for(std::chrono::milliseconds(100));
+#endif
+	};
+
+	return t;
+};
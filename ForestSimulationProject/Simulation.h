@@ -0,0 +1,164 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include "ForestBoard.h"
+#include "DayKernels.h"
+#include "CounterRandom.h"
+#include "PoissonTable.h"
+#include "GeometricSkip.h"
+#include "FireCalendar.h"
+
+//Seasonal parameters of one season.
+struct SeasonParameters {
+	double seasonal_leaf_fall_inc;    //Seasonal impact on average leaf fall.
+	double seasonal_leaf_growth_inc;  //Seasonal impact on average leaf growth.
+	double p_fire_season_factor;      //Seasonal probability of catching fire, as a multiple of p_fire_season_base_rate.
+};
+
+//Immutable configuration of a simulation: the model parameters, and everything derived from them once by prepare_simulation_config().
+//Set the parameters, prepare it, then only ever pass it on as const SimulationConfig &. Any number of runs and threads can share one,
+//and runs with different configurations can go on side by side in one process.
+struct SimulationConfig {
+	//Model parameters
+	int T = 18250; //730;// 18250;              //Maximum runtime of simulation in days.
+	int raking_frequency = 12;                //Raking cycle in days.
+	double raking_amount = 0.06;              //Volume of leaf removed at each raking cycle. Value between 0 - 1.
+	double nutrient_depletion_rate = 0.001;   //Amount of nutrients depleted from each forest block per day.
+	double average_leaf_fall = 0.001;         //Average daily leaf fall.
+	double average_leaf_growth = 0.001;       //Average daily leaf growth.
+	int average_fire_duration = 5;            //Avergae length of fire.
+	int season_length = 91;                   //Length of each season in days.
+	double p_fire_neighbor_c = 0.005; //Fixed probability increase of catching fire for each corner neighbor on fire. (4*p_fire_neighbor_c + 4*p_fire_neighbor_e <= 0.5)
+	double p_fire_neighbor_e = 0.005; //Fixed probability increase of catching fire for each edge neighbor on fire. (4*p_fire_neighbor_c + 4*p_fire_neighbor_e <= 0.5)
+	double p_fire_season_base_rate = 0.00001; //Fixed probability increase of catching fire by season.
+	double leaf_fire_contribution = 0.000007; //the amount that the leaf volume contributes to catching on fire
+
+	//Seasonal parameters for spring, summer, fall & winter (season 0, 1, 2, 3), respectively.
+	SeasonParameters seasons[4] = {
+		{ 0.001, 0.005, 1 },
+		{ 0.001, 0.001, 2 },
+		{ 0.005, 0.000, 8 },
+		{ 0.000, 0.000, 4 },
+	};
+
+	int rows = 1;                             //Number of rows of forest blocks.
+	int cols = 1;                             //Number of cols of forest blocks.
+	std::uint64_t seed = 0;                   //Seed of the random number generator.
+	bool event_engine = false;                //Run trials with run_trial_events() instead of day by day.
+
+	//Derived by prepare_simulation_config()
+	int raking_amount_fixed = 0;              //raking_amount in fixed point thousandths of a full tile (see volumeScale).
+	int nutrient_depletion_rate_fixed = 0;    //nutrient_depletion_rate in fixed point thousandths.
+
+	//Poisson samplers. Leaf fall and leaf growth are drawn together as one Poisson value of the summed rate
+	//(a sum of independent Poisson values is Poisson), one table per season, in integer thousandths of leaf volume.
+	PoissonTable leaf_increment_tables[4];
+	PoissonTable fire_duration_table;
+
+	//Fire probabilities of every season as integer thresholds on a raw 64 bit draw.
+	FireCheckParams fire_check_params[4];
+
+	//Background ignitions of every season, for rows with no fire in or next to them: geometric gaps between the tiles that
+	//could ignite at the largest background probability (a full leaf volume), thinned down to each tile's own probability.
+	GeometricSkip ignition_skips[4];
+
+	//Event engine only: leaf increments of 1 .. quiet_interval_max days at once, quiet_leaf_tables[season * (quiet_interval_max + 1) + days].
+	//PoissonTable starts from e^-mean, which underflows past a mean of ~700, so the longest interval is capped below that.
+	int quiet_interval_max = 0;
+	std::vector<PoissonTable> quiet_leaf_tables;
+
+	//Every draw is addressed by (trial, day, tile, purpose), so it does not depend on the order draws are made in.
+	CounterRandom generator;
+};
+
+//Fill in the derived part of config from its parameters. Exits if a volume parameter is not a whole number of thousandths.
+void prepare_simulation_config(SimulationConfig & config);
+
+//a + b, capped at the largest threshold
+std::uint64_t add_saturate(std::uint64_t a, std::uint64_t b);
+
+//Season of day t: the seasons go round every season_length days, starting in spring.
+int season_of_day(const SimulationConfig & config, int t);
+
+//Whether the leaves are raked on day t.
+bool is_raking_day(const SimulationConfig & config, int t);
+
+class WorkStealingPool;
+
+//A fire event and the day it happens on
+struct ScheduledFireEvent {
+	int day;
+	FireEvent event;
+};
+
+//Per row scratch buffers of step(), one set per thread working on a board.
+struct RowScratch {
+	RowScratch(const SimulationConfig & config, int words_per_row);
+
+	//Pre-drawn leaf fall + growth of every tile in the current row, in thousandths, and the raw draws they come from
+	std::vector<volume_t> leaf_increments;
+	std::vector<std::uint64_t> leaf_draws;
+
+	//Fire check buffers: burning neighbor counts per word, one raw random draw per tile and the tiles that catch fire
+	std::vector<NeighborFireCounts> neighbor_counts;
+	bool neighbor_counts_zero = false;        //neighbor_counts is all zero from a row with no fire near it
+	std::vector<std::uint64_t> fire_draws;
+	std::vector<std::uint64_t> ignitions;
+
+	//Fire starts and ends scheduled by today's fire checks, added to the calendar at the end of the day
+	std::vector<ScheduledFireEvent> new_fire_events;
+};
+
+//Where a tile's leaf volume became full during a quiet interval of run_trial_events(): need more thousandths took it to full,
+//out of the arrivals drawn for its days first_day + 1 .. last_day.
+struct SaturationCrossing {
+	int first_day = -1;
+	int last_day = -1;
+	int need = 0;
+	int arrivals = 0;
+};
+
+//Mutable state of simulation runs: the board, its scheduled fire starts and ends, the current season, and the scratch buffers of whoever steps the board.
+struct SimulationState {
+	explicit SimulationState(const SimulationConfig & config);
+
+	ForestBoard board;
+	int season = 0;                           //Current season. 0, 1, 2, 3 for spring, summer, fall & winter, respectively.
+
+	RowScratch scratch;                       //for step()
+	std::vector<RowScratch> band_scratch;     //one per row band, for step_banded()
+
+	FireCalendar fire_calendar;               //Fire starts and ends by day, the fire durations are at most fire_duration_table's largest value.
+
+	//Event engine only: the day every tile's leaves are up to date with, and where each last became full
+	std::vector<int> tile_days;
+	std::vector<SaturationCrossing> crossings;
+};
+
+//Simulate day time of a trial on state.board.
+void step(const SimulationConfig & config, SimulationState & state, int trial, int time);
+
+//Same day as step(), with the board split into one band of rows per worker of band_pool, for grids too big for one core.
+//Every band first updates its rows and checks the fires of the rows whose neighbors are all in the band (or the board border).
+//After a barrier, every band checks its first and last row, whose neighbor rows (the halo) belong to the next bands and are updated by now.
+//A second barrier ends the day. The bands share the board's bit planes, so the halo rows are read in place instead of copied.
+//Draws are per tile, so the day is the same as with step() for any number of bands.
+void step_banded(const SimulationConfig & config, SimulationState & state, WorkStealingPool & band_pool, int trial, int time);
+
+//Run one trial from a reset board until T days or an absorbing state is reached. Returns the number of days simulated.
+//The trial's random draws only depend on the generator seed and the trial number, so the same seed and trial always give the same run.
+//With trace set, prints the board totals after every day. With band_pool set, every day runs on it with step_banded().
+//With config.event_engine set, runs run_trial_events() instead.
+int run_trial(const SimulationConfig & config, SimulationState & state, int trial, bool & absorbing_state, std::ostream * trace, WorkStealingPool * band_pool = nullptr);
+
+//Same trial as run_trial() by events: days with a fire burning or scheduled are stepped one by one as usual, and the quiet
+//stretches in between jump from event to event (raking days, season changes, ignitions) instead of simulating every day.
+//Within a quiet interval a tile's leaf fall and growth of all its days is one Poisson draw, and tiles are only brought up to date
+//at the interval's end or when an ignition candidate needs their leaf volume. Same model and statistics as run_trial(), but other
+//draws, so a seed and trial give a different run than run_trial(). With trace set, prints a line at the end of every interval.
+int run_trial_events(const SimulationConfig & config, SimulationState & state, int trial, bool & absorbing_state, std::ostream * trace, WorkStealingPool * band_pool = nullptr);
+
+//Trials can run in parallel, console lines are written under this lock so they don't interleave
+extern std::mutex console_mutex;
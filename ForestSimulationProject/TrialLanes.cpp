@@ -0,0 +1,430 @@
+#include "TrialLanes.h"
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+const int lanes = TrialLanes::lanes;
+const int maxTiles = TrialLanes::maxTiles;
+
+//number of set bits
+int countTiles(std::uint64_t bits)
+{
+	int count = 0;
+	for (; bits != 0; bits &= bits - 1)
+		++count;
+	return count;
+}
+
+constexpr std::uint64_t tileBitOf(int tile)
+{
+	return std::uint64_t(1) << tile;
+}
+
+//Per tile masks of the edge and corner neighbors, and per row the tiles of the row and the rows next to it
+struct NeighborMasks
+{
+	std::uint64_t edge[maxTiles];
+	std::uint64_t corner[maxTiles];
+	std::uint64_t nearRow[maxTiles];
+};
+
+constexpr bool isOnBoard(int row, int col, int rows, int cols)
+{
+	return row >= 0 && row < rows && col >= 0 && col < cols;
+}
+
+constexpr NeighborMasks makeNeighborMasks(int rows, int cols)
+{
+	NeighborMasks masks = {};
+	for (int i = 0; i < rows; ++i)
+	{
+		for (int j = 0; j < cols; ++j)
+		{
+			int tile = i * cols + j;
+			for (int k = 0; k < 4; ++k)
+			{
+				if (isOnBoard(i + edgeStencil[k].row, j + edgeStencil[k].col, rows, cols))
+					masks.edge[tile] |= tileBitOf((i + edgeStencil[k].row) * cols + j + edgeStencil[k].col);
+				if (isOnBoard(i + cornerStencil[k].row, j + cornerStencil[k].col, rows, cols))
+					masks.corner[tile] |= tileBitOf((i + cornerStencil[k].row) * cols + j + cornerStencil[k].col);
+			}
+
+			for (int near = (i > 0 ? i - 1 : 0); near <= (i + 1 < rows ? i + 1 : rows - 1); ++near)
+				masks.nearRow[near] |= tileBitOf(tile);
+		}
+	}
+	return masks;
+}
+
+//Board size fixed at compile time: every loop over tiles and rows has a constant bound the compiler can unroll,
+//the neighbor masks are built at compile time, and the lane arrays are std::arrays
+template<int Rows, int Cols>
+struct StaticShape
+{
+	static constexpr int rows = Rows, cols = Cols, tiles = Rows * Cols;
+	static constexpr int fixedTiles = tiles, fixedRows = rows; //array sizes
+	static constexpr NeighborMasks masks = makeNeighborMasks(Rows, Cols);
+
+	explicit StaticShape(const SimulationConfig&) {}
+};
+
+template<int Rows, int Cols> constexpr int StaticShape<Rows, Cols>::rows;
+template<int Rows, int Cols> constexpr int StaticShape<Rows, Cols>::cols;
+template<int Rows, int Cols> constexpr int StaticShape<Rows, Cols>::tiles;
+template<int Rows, int Cols> constexpr NeighborMasks StaticShape<Rows, Cols>::masks;
+
+//Board size read at run time, for the sizes without a compiled engine
+struct DynamicShape
+{
+	int rows, cols, tiles;
+	static constexpr int fixedTiles = 0, fixedRows = 0; //vectors
+	NeighborMasks masks;
+
+	explicit DynamicShape(const SimulationConfig& config)
+		: rows(config.rows), cols(config.cols), tiles(config.rows * config.cols), masks(makeNeighborMasks(config.rows, config.cols)) {}
+};
+
+//size values of T: a std::array for a size known at compile time, a std::vector sized at run time for Size 0
+template<typename T, int Size>
+struct LaneArray
+{
+	std::array<T, Size> values;
+
+	void resize(size_t) {}
+	T& operator[](size_t i) { return values[i]; }
+	T* data() { return values.data(); }
+};
+
+template<typename T>
+struct LaneArray<T, 0>
+{
+	std::vector<T> values;
+
+	void resize(size_t size) { values.resize(size); }
+	T& operator[](size_t i) { return values[i]; }
+	T* data() { return values.data(); }
+};
+
+template<typename Shape>
+class ShapedTrialLanes : public TrialLanes
+{
+public:
+	explicit ShapedTrialLanes(const SimulationConfig& config);
+
+	void run(int firstTrial, int count, const std::function<void(int, int, bool)>& finished) override;
+
+private:
+	static constexpr int fixedPairs = (Shape::fixedTiles + 1) / 2;
+
+	int pairs() const { return (shape.tiles + 1) / 2; } //Philox blocks per lane for the leaf increments, two tiles each
+
+	volume_t* boardOf(int lane) { return leaves.data() + size_t(lane) * shape.tiles; }
+
+	void startTrial(int lane, int trial);
+	void drawDay();
+	void morning(int lane);
+	void checkFires(int lane);
+	void checkBackgroundFires(int lane, int row, std::uint64_t firstGapDraw);
+	void igniteTile(int lane, int tile);
+
+	//whether the lane's trial reached an absorbing state today, printed like run_trial() does
+	bool isAbsorbing(int lane);
+
+	const SimulationConfig& config;
+	Shape shape;
+
+	//board of every lane, each one contiguous as a lane's day is worked through one lane at a time (boardOf(lane)[tile]),
+	//and bit tile of onFire[lane]. Nutrients never feed back into the leaves or the fires, so they are not kept
+	LaneArray<volume_t, Shape::fixedTiles * lanes> leaves;
+	std::uint64_t onFire[lanes];
+
+	int trials[lanes];
+	int days[lanes];
+	bool active[lanes];
+	std::vector<FireCalendar> calendars;
+	std::vector<ScheduledFireEvent> newFireEvents[lanes];
+
+	//counters and values of the day's draws: leaf increments of pair p of lane l at l * pairs + p,
+	//the first ignition gap of row i of lane l at l * rows + i
+	LaneArray<std::uint32_t, fixedPairs * lanes> leafTrials, leafDays, leafPairs;
+	LaneArray<std::uint64_t, 2 * fixedPairs * lanes> leafDraws;
+	LaneArray<std::uint32_t, Shape::fixedRows * lanes> gapTrials, gapDays, gapPairs;
+	LaneArray<std::uint64_t, 2 * Shape::fixedRows * lanes> gapDraws;
+
+	//per season, first gap draws below it pass over a whole row (GeometricSkip::skipBound)
+	std::uint64_t rowSkipBounds[4];
+};
+
+template<typename Shape>
+ShapedTrialLanes<Shape>::ShapedTrialLanes(const SimulationConfig& config) : config(config), shape(config)
+{
+	leaves.resize(size_t(shape.tiles) * lanes);
+	calendars.assign(lanes, FireCalendar(std::max(config.fire_duration_table.getMaxValue(), 2)));
+
+	leafTrials.resize(size_t(lanes) * pairs());
+	leafDays.resize(size_t(lanes) * pairs());
+	leafPairs.resize(size_t(lanes) * pairs());
+	leafDraws.resize(2 * size_t(lanes) * pairs());
+	gapTrials.resize(size_t(lanes) * shape.rows);
+	gapDays.resize(size_t(lanes) * shape.rows);
+	gapPairs.resize(size_t(lanes) * shape.rows);
+	gapDraws.resize(2 * size_t(lanes) * shape.rows);
+	for (int lane = 0; lane < lanes; ++lane)
+	{
+		for (int p = 0; p < pairs(); ++p)
+			leafPairs[lane * pairs() + p] = std::uint32_t(p);
+		//a row's search starts at its first tile, the first value of the pair for even tiles and the second for odd ones
+		for (int i = 0; i < shape.rows; ++i)
+			gapPairs[lane * shape.rows + i] = std::uint32_t(i * shape.cols / 2);
+	}
+
+	for (int s = 0; s < 4; ++s)
+		rowSkipBounds[s] = config.ignition_skips[s].skipBound(shape.cols);
+}
+
+template<typename Shape>
+void ShapedTrialLanes<Shape>::startTrial(int lane, int trial)
+{
+	std::fill(boardOf(lane), boardOf(lane) + shape.tiles, volume_t(0));
+	onFire[lane] = 0;
+	calendars[lane].clear();
+
+	trials[lane] = trial;
+	days[lane] = 0;
+	active[lane] = true;
+	std::fill(leafTrials.data() + lane * pairs(), leafTrials.data() + (lane + 1) * pairs(), std::uint32_t(trial));
+	std::fill(gapTrials.data() + lane * shape.rows, gapTrials.data() + (lane + 1) * shape.rows, std::uint32_t(trial));
+}
+
+template<typename Shape>
+void ShapedTrialLanes<Shape>::run(int firstTrial, int count, const std::function<void(int, int, bool)>& finished)
+{
+	int nextTrial = firstTrial, lastTrial = firstTrial + count;
+	for (int lane = 0; lane < lanes; ++lane)
+	{
+		if (nextTrial < lastTrial)
+			startTrial(lane, nextTrial++);
+		else
+			active[lane] = false;
+	}
+
+	for (int running = std::min(count, lanes); running > 0;)
+	{
+		drawDay();
+		for (int lane = 0; lane < lanes; ++lane)
+		{
+			if (!active[lane])
+				continue;
+
+			morning(lane);
+			checkFires(lane);
+
+			bool absorbingState = isAbsorbing(lane);
+			++days[lane];
+			if (!absorbingState && days[lane] < config.T)
+				continue;
+
+			//refill the lane with the next trial
+			finished(trials[lane], days[lane], absorbingState);
+			if (nextTrial < lastTrial)
+			{
+				startTrial(lane, nextTrial++);
+			}
+			else
+			{
+				active[lane] = false;
+				--running;
+			}
+		}
+	}
+}
+
+template<typename Shape>
+void ShapedTrialLanes<Shape>::drawDay()
+{
+	for (int lane = 0; lane < lanes; ++lane)
+	{
+		std::fill(leafDays.data() + lane * pairs(), leafDays.data() + (lane + 1) * pairs(), std::uint32_t(days[lane]));
+		std::fill(gapDays.data() + lane * shape.rows, gapDays.data() + (lane + 1) * shape.rows, std::uint32_t(days[lane]));
+	}
+
+	config.generator.laneBlocks(leafDraws.data(), leafTrials.data(), leafDays.data(), leafPairs.data(), lanes * pairs(), RandomPurpose::LeafIncrement);
+	config.generator.laneBlocks(gapDraws.data(), gapTrials.data(), gapDays.data(), gapPairs.data(), lanes * shape.rows, RandomPurpose::IgnitionSkip);
+}
+
+//Leaf update, raking and the day's fire starts and ends of one lane, as leaf_morning_update_row() does row by row
+template<typename Shape>
+void ShapedTrialLanes<Shape>::morning(int lane)
+{
+	int day = days[lane];
+	const PoissonTable& leafIncrementTable = config.leaf_increment_tables[season_of_day(config, day)];
+	int rakeAmount = is_raking_day(config, day) ? config.raking_amount_fixed : 0;
+	const std::uint64_t* draws = leafDraws.data() + 2 * size_t(lane) * pairs();
+	volume_t* board = boardOf(lane);
+
+	for (int tile = 0; tile < shape.tiles; ++tile)
+	{
+		int leaf = board[tile];
+		if (!(onFire[lane] & tileBitOf(tile)))
+			leaf = std::min(leaf + leafIncrementTable(draws[tile]), volumeScale);
+		board[tile] = volume_t(std::max(leaf - rakeAmount, 0));
+	}
+
+	for (const FireEvent& event : calendars[lane].eventsOf(day))
+	{
+		if (event.start)
+		{
+			board[event.tile] = 0;
+			onFire[lane] |= tileBitOf(event.tile);
+		}
+		else
+		{
+			onFire[lane] &= ~tileBitOf(event.tile);
+		}
+	}
+}
+
+//New fire generations of one lane, as check_new_fire_row() does, then the day's new fires onto the lane's calendar
+template<typename Shape>
+void ShapedTrialLanes<Shape>::checkFires(int lane)
+{
+	int day = days[lane];
+	int season = season_of_day(config, day);
+	const FireCheckParams& params = config.fire_check_params[season];
+	bool sparse = config.ignition_skips[season].isSparse();
+	std::uint64_t rowDraws[maxTiles];
+	const volume_t* board = boardOf(lane);
+
+	for (int i = 0; i < shape.rows; ++i)
+	{
+		if (!(onFire[lane] & shape.masks.nearRow[i]) && sparse)
+		{
+			//the first gap draw passes over the whole row nearly always
+			std::uint64_t firstGapDraw = gapDraws[2 * size_t(lane * shape.rows + i) + (i * shape.cols) % 2];
+			if (firstGapDraw >= rowSkipBounds[season])
+				checkBackgroundFires(lane, i, firstGapDraw);
+			continue;
+		}
+
+		config.generator.fill(rowDraws, trials[lane], day, i * shape.cols, shape.cols, RandomPurpose::Ignition);
+		for (int j = 0; j < shape.cols; ++j)
+		{
+			int tile = i * shape.cols + j;
+			if (onFire[lane] & tileBitOf(tile))
+				continue;
+
+			std::uint64_t threshold = add_saturate(params.season, board[tile] * params.leafUnit);
+			threshold = add_saturate(threshold, params.neighbors[countTiles(onFire[lane] & shape.masks.edge[tile])][countTiles(onFire[lane] & shape.masks.corner[tile])]);
+			if (rowDraws[j] < threshold)
+				igniteTile(lane, tile);
+		}
+	}
+
+	calendars[lane].finishDay(day);
+	for (const ScheduledFireEvent& scheduled : newFireEvents[lane])
+		calendars[lane].schedule(scheduled.day, scheduled.event);
+	newFireEvents[lane].clear();
+}
+
+//Background ignitions of a row with no fire near it, the same gap search as check_background_fire_row()
+template<typename Shape>
+void ShapedTrialLanes<Shape>::checkBackgroundFires(int lane, int row, std::uint64_t firstGapDraw)
+{
+	int trial = trials[lane], day = days[lane];
+	int season = season_of_day(config, day);
+	const GeometricSkip& skip = config.ignition_skips[season];
+	const FireCheckParams& params = config.fire_check_params[season];
+	const volume_t* board = boardOf(lane);
+
+	for (int j = 0; j < shape.cols; ++j)
+	{
+		int tile = row * shape.cols + j;
+		j += skip(j == 0 ? firstGapDraw : config.generator(trial, day, tile, RandomPurpose::IgnitionSkip));
+		if (j >= shape.cols)
+			break;
+
+		tile = row * shape.cols + j;
+		std::uint64_t threshold = add_saturate(add_saturate(params.season, board[tile] * params.leafUnit), params.neighbors[0][0]);
+		if (skip.accept(config.generator(trial, day, tile, RandomPurpose::Ignition), threshold))
+			igniteTile(lane, tile);
+	}
+}
+
+//as ignite_tile()
+template<typename Shape>
+void ShapedTrialLanes<Shape>::igniteTile(int lane, int tile)
+{
+	int day = days[lane];
+	int fireDuration = config.fire_duration_table(config.generator(trials[lane], day, tile, RandomPurpose::FireDuration));
+	newFireEvents[lane].push_back({ day + 1, { tile, true } });
+	newFireEvents[lane].push_back({ day + std::max(fireDuration, 2), { tile, false } });
+}
+
+template<typename Shape>
+bool ShapedTrialLanes<Shape>::isAbsorbing(int lane)
+{
+	//every tile empty or every tile full, which the first tile that differs from tile 0 rules out
+	const volume_t* board = boardOf(lane);
+	int leaf = board[0];
+	if (leaf != 0 && leaf != volumeScale)
+		return false;
+	for (int tile = 1; tile < shape.tiles; ++tile)
+	{
+		if (board[tile] != leaf)
+			return false;
+	}
+
+	std::lock_guard<std::mutex> lock(console_mutex);
+	std::cout << "Reaches absorbing state " << (leaf == 0 ? "barren" : "overgrowth") << " trial : " << trials[lane] << " t : " << days[lane] << std::endl;
+	return true;
+}
+
+template<int Rows, int Cols>
+std::unique_ptr<TrialLanes> createCompiled(const SimulationConfig& config)
+{
+	return std::unique_ptr<TrialLanes>(new ShapedTrialLanes<StaticShape<Rows, Cols>>(config));
+}
+
+//The board sizes with an engine compiled for them: every size up to 4 x 4, which is most of the sweeps, and the 4 x 5 of the results
+struct CompiledSize
+{
+	int rows, cols;
+	std::unique_ptr<TrialLanes>(*create)(const SimulationConfig& config);
+};
+
+const CompiledSize compiledSizes[] = {
+	{ 1, 1, &createCompiled<1, 1> }, { 1, 2, &createCompiled<1, 2> }, { 1, 3, &createCompiled<1, 3> }, { 1, 4, &createCompiled<1, 4> },
+	{ 2, 1, &createCompiled<2, 1> }, { 2, 2, &createCompiled<2, 2> }, { 2, 3, &createCompiled<2, 3> }, { 2, 4, &createCompiled<2, 4> },
+	{ 3, 1, &createCompiled<3, 1> }, { 3, 2, &createCompiled<3, 2> }, { 3, 3, &createCompiled<3, 3> }, { 3, 4, &createCompiled<3, 4> },
+	{ 4, 1, &createCompiled<4, 1> }, { 4, 2, &createCompiled<4, 2> }, { 4, 3, &createCompiled<4, 3> }, { 4, 4, &createCompiled<4, 4> },
+	{ 4, 5, &createCompiled<4, 5> },
+};
+
+const CompiledSize* findCompiledSize(const SimulationConfig& config)
+{
+	for (const CompiledSize& size : compiledSizes)
+	{
+		if (size.rows == config.rows && size.cols == config.cols)
+			return &size;
+	}
+	return nullptr;
+}
+
+}
+
+bool TrialLanes::isCompiledFor(const SimulationConfig& config)
+{
+	return findCompiledSize(config) != nullptr;
+}
+
+std::unique_ptr<TrialLanes> TrialLanes::create(const SimulationConfig& config)
+{
+	const CompiledSize* size = findCompiledSize(config);
+	if (size)
+		return size->create(config);
+	return std::unique_ptr<TrialLanes>(new ShapedTrialLanes<DynamicShape>(config));
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include "Simulation.h"
+
+//Trials of a small board run side by side, one per lane of a batch, for sweeps of tiny grids where a day is so little work
+//that the per trial and per day overhead is most of the time. The leaf increment draws and first ignition gaps of every lane's day
+//come from one vectorized Philox call (see RandomLaneBlocks), the rest of a lane's day (table lookups, fire checks) is scalar.
+//A lane whose trial ends takes the next trial straight away, so the batch stays full until the trials run out.
+//Every lane follows step() tile for tile with the same draws, so every trial ends exactly as with run_trial().
+class TrialLanes
+{
+public:
+	static constexpr int lanes = 16;
+	static constexpr int maxTiles = 64; //the fire state of a lane's board is one bit word
+
+	static bool fits(const SimulationConfig& config) { return config.rows * config.cols <= maxTiles; }
+
+	//whether config's board size has an engine compiled for it, with its loops and neighbor masks fixed at compile time
+	static bool isCompiledFor(const SimulationConfig& config);
+
+	//the engine compiled for config's board size if there is one, otherwise the one that takes any size up to maxTiles
+	static std::unique_ptr<TrialLanes> create(const SimulationConfig& config);
+
+	virtual ~TrialLanes() {}
+
+	//Run trials [firstTrial, firstTrial + count), calling finished(trial, t, absorbingState) as each one ends, in the order they end
+	virtual void run(int firstTrial, int count, const std::function<void(int, int, bool)>& finished) = 0;
+};
@@ -0,0 +1,147 @@
+#include "TrialSummary.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <type_traits>
+
+//Format tag of the first line of a summary file
+const char * trial_summary_format = "forest_trial_summary";
+const int trial_summary_version = 2;
+
+TrialSummary make_trial_summary(const SimulationConfig & config, const std::string & engine, int first_trial) {
+	TrialSummary summary;
+	summary.seed = config.seed;
+	summary.rows = config.rows;
+	summary.cols = config.cols;
+	summary.raking_frequency = config.raking_frequency;
+	summary.T = config.T;
+	summary.engine = engine;
+	summary.first_trial = first_trial;
+	return summary;
+};
+
+void add_trial(TrialSummary & summary, int t, bool absorbing_state) {
+	++summary.trials;
+	if (!absorbing_state) {
+		return;
+	};
+
+	summary.min_t = (summary.absorbing == 0) ? t : std::min(summary.min_t, t);
+	summary.max_t = (summary.absorbing == 0) ? t : std::max(summary.max_t, t);
+	++summary.absorbing;
+	summary.sum_t += t;
+	summary.sum_t_squared += std::int64_t(t) * t;
+};
+
+bool write_trial_summary(const TrialSummary & summary, const std::string & path) {
+	std::ofstream file(path.c_str());
+	file << trial_summary_format << " " << trial_summary_version << std::endl;
+	file << "seed " << summary.seed << std::endl;
+	file << "rows " << summary.rows << std::endl;
+	file << "cols " << summary.cols << std::endl;
+	file << "raking_frequency " << summary.raking_frequency << std::endl;
+	file << "T " << summary.T << std::endl;
+	file << "engine " << summary.engine << std::endl;
+	file << "first_trial " << summary.first_trial << std::endl;
+	file << "trials " << summary.trials << std::endl;
+	file << "absorbing " << summary.absorbing << std::endl;
+	file << "sum_t " << summary.sum_t << std::endl;
+	file << "sum_t_squared " << summary.sum_t_squared << std::endl;
+	file << "min_t " << summary.min_t << std::endl;
+	file << "max_t " << summary.max_t << std::endl;
+	return bool(file);
+};
+
+//Whole number field text as a T, false if it is something else or out of T's range
+template<typename T>
+bool parse_whole_number(const std::string & text, T & value) {
+	if (text.empty() || text[0] == '+' || (text[0] == '-' && !std::is_signed<T>::value)) {
+		return false;
+	};
+	std::istringstream stream(text);
+	return (stream >> value) && stream.peek() == std::char_traits<char>::eof();
+};
+
+bool read_trial_summary(const std::string & path, TrialSummary & summary) {
+	std::ifstream file(path.c_str());
+	std::string format;
+	int version = 0;
+	if (!(file >> format >> version) || format != trial_summary_format || version != trial_summary_version) {
+		std::cout << path << " is not a trial summary file" << std::endl;
+		return false;
+	};
+
+	std::map<std::string, std::string> values;
+	std::string name, value;
+	while (file >> name >> value) {
+		values[name] = value;
+	};
+
+	const char * names[] = { "seed", "rows", "cols", "raking_frequency", "T", "engine", "first_trial", "trials", "absorbing", "sum_t", "sum_t_squared", "min_t", "max_t" };
+	for (const char * required : names) {
+		if (values.find(required) == values.end()) {
+			std::cout << path << " has no " << required << std::endl;
+			return false;
+		};
+	};
+
+	//every other value is a whole number
+	summary.engine = values["engine"];
+	bool valid = parse_whole_number(values["seed"], summary.seed)
+		&& parse_whole_number(values["rows"], summary.rows)
+		&& parse_whole_number(values["cols"], summary.cols)
+		&& parse_whole_number(values["raking_frequency"], summary.raking_frequency)
+		&& parse_whole_number(values["T"], summary.T)
+		&& parse_whole_number(values["first_trial"], summary.first_trial)
+		&& parse_whole_number(values["trials"], summary.trials)
+		&& parse_whole_number(values["absorbing"], summary.absorbing)
+		&& parse_whole_number(values["sum_t"], summary.sum_t)
+		&& parse_whole_number(values["sum_t_squared"], summary.sum_t_squared)
+		&& parse_whole_number(values["min_t"], summary.min_t)
+		&& parse_whole_number(values["max_t"], summary.max_t);
+	if (!valid) {
+		std::cout << path << " has a value that is not a whole number or is out of range" << std::endl;
+		return false;
+	};
+	return true;
+};
+
+bool merge_trial_summaries(std::vector<TrialSummary> shards, TrialSummary & merged) {
+	if (shards.empty()) {
+		std::cout << "No trial summaries to merge" << std::endl;
+		return false;
+	};
+
+	std::sort(shards.begin(), shards.end(), [](const TrialSummary & a, const TrialSummary & b) { return a.first_trial < b.first_trial; });
+
+	merged = shards[0];
+	std::int64_t next_trial = std::int64_t(shards[0].first_trial) + shards[0].trials;
+	for (size_t s = 1; s < shards.size(); ++s) {
+		const TrialSummary & shard = shards[s];
+		if (shard.seed != merged.seed || shard.rows != merged.rows || shard.cols != merged.cols
+			|| shard.raking_frequency != merged.raking_frequency || shard.T != merged.T || shard.engine != merged.engine) {
+			std::cout << "Shard of trials from " << shard.first_trial << " is from a different run (seed, forest size, raking frequency, T or engine)" << std::endl;
+			return false;
+		};
+		if (shard.first_trial < next_trial) {
+			std::cout << "Shard of trials from " << shard.first_trial << " overlaps the trials before " << next_trial << std::endl;
+			return false;
+		};
+		if (shard.first_trial > next_trial) {
+			std::cout << "Trials " << next_trial << " to " << shard.first_trial - 1 << " are missing" << std::endl;
+		};
+
+		if (shard.absorbing > 0) {
+			merged.min_t = (merged.absorbing == 0) ? shard.min_t : std::min(merged.min_t, shard.min_t);
+			merged.max_t = (merged.absorbing == 0) ? shard.max_t : std::max(merged.max_t, shard.max_t);
+		};
+		merged.trials += shard.trials;
+		merged.absorbing += shard.absorbing;
+		merged.sum_t += shard.sum_t;
+		merged.sum_t_squared += shard.sum_t_squared;
+		next_trial = std::int64_t(shard.first_trial) + shard.trials;
+	};
+	return true;
+};
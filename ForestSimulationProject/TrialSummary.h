@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Simulation.h"
+
+//Mergeable summary of a range of trials: how many ran, and exact integer sums of the days t of those that reached an absorbing state.
+//A sweep can be split into shards, one process per range of trials, all with the same seed. Every trial's draws only depend on the seed
+//and its trial number, and integer sums don't depend on the order they are added in, so the merged shards give exactly the
+//statistics of running the whole sweep in one process, whatever the shards and their order.
+struct TrialSummary {
+	//The run the trials belong to. Only summaries of the same run can be merged
+	std::uint64_t seed = 0;
+	int rows = 0;
+	int cols = 0;
+	int raking_frequency = 0;
+	int T = 0;
+	std::string engine;                       //day, event or lanes, engines with other draws give other runs of the same seed
+
+	int first_trial = 0;                      //Trials first_trial .. first_trial + trials - 1, for a merged summary the lowest first trial of its shards.
+	std::int64_t trials = 0;
+	std::int64_t absorbing = 0;               //Trials that reached an absorbing state, only these count in the statistics of t.
+	std::int64_t sum_t = 0;
+	std::int64_t sum_t_squared = 0;
+	int min_t = 0;
+	int max_t = 0;
+};
+
+//Empty summary of the run of config on engine, starting at first_trial.
+TrialSummary make_trial_summary(const SimulationConfig & config, const std::string & engine, int first_trial);
+
+//Count one more trial into summary.
+void add_trial(TrialSummary & summary, int t, bool absorbing_state);
+
+//Write summary as a small text file of "name value" lines. Returns false if the file can't be written.
+bool write_trial_summary(const TrialSummary & summary, const std::string & path);
+
+//Read a file written by write_trial_summary. Prints what is wrong and returns false for a missing or malformed file.
+bool read_trial_summary(const std::string & path, TrialSummary & summary);
+
+//Merge shards into one summary. Prints what is wrong and returns false if they come from different runs (or engines) or their trials overlap.
+//Missing trials between the shards are reported, the merged statistics are then those of the trials present.
+bool merge_trial_summaries(std::vector<TrialSummary> shards, TrialSummary & merged);
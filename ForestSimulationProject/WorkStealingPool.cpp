@@ -0,0 +1,118 @@
+#include "WorkStealingPool.h"
+
+WorkStealingPool::WorkStealingPool(int numWorkers)
+{
+	if (numWorkers < 1)
+		numWorkers = 1;
+
+	//every worker exists before any thread starts stealing from them
+	for (int w = 0; w < numWorkers; ++w)
+		workers.emplace_back(new Worker());
+	for (int w = 0; w < numWorkers; ++w)
+		workers[w]->thread = std::thread(&WorkStealingPool::workerLoop, this, w);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+
+	for (auto& worker : workers)
+		worker->thread.join();
+}
+
+void WorkStealingPool::run(int numTasks, const std::function<void(int, int)>& newTask)
+{
+	if (numTasks <= 0)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		task = &newTask;
+		pending = numTasks;
+	}
+
+	//deal the tasks out round robin, stealing evens out whatever this gets wrong
+	int numWorkers = getNumWorkers();
+	for (int index = 0; index < numTasks; ++index)
+	{
+		Worker& worker = *workers[index % numWorkers];
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		worker.tasks.push_back(index);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		++batch;
+	}
+	wake.notify_all();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this] { return pending == 0; });
+	task = nullptr;
+}
+
+void WorkStealingPool::workerLoop(int worker)
+{
+	std::uint64_t seenBatch = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return stopping || batch != seenBatch; });
+			if (stopping)
+				return;
+			seenBatch = batch;
+		}
+
+		//a task taken here may already belong to the next batch, so the function is looked up per task
+		int index;
+		while (takeTask(worker, index))
+		{
+			const std::function<void(int, int)>* current;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				current = task;
+			}
+
+			(*current)(worker, index);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--pending == 0)
+				done.notify_all();
+		}
+	}
+}
+
+bool WorkStealingPool::takeTask(int worker, int& index)
+{
+	{
+		Worker& own = *workers[worker];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty())
+		{
+			index = own.tasks.front();
+			own.tasks.pop_front();
+			return true;
+		}
+	}
+
+	int numWorkers = getNumWorkers();
+	for (int k = 1; k < numWorkers; ++k)
+	{
+		Worker& victim = *workers[(worker + k) % numWorkers];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			index = victim.tasks.back();
+			victim.tasks.pop_back();
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Persistent pool of worker threads that runs batches of independent tasks.
+//Every worker has its own task deque: it takes tasks from the front of its own deque and, once that is empty,
+//steals from the back of the others. Tasks of very different lengths (e.g. trials that end after 14 days or run
+//to the day cap) stay balanced, workers that drew short tasks take over the queued work of those stuck on long ones.
+class WorkStealingPool
+{
+public:
+	explicit WorkStealingPool(int numWorkers);
+	~WorkStealingPool();
+
+	WorkStealingPool(const WorkStealingPool&) = delete;
+	WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+	int getNumWorkers() const { return int(workers.size()); }
+
+	//run task(worker, index) for every index in [0, numTasks) and wait for all of them.
+	//worker is the index of the worker thread running the task, for per worker state
+	void run(int numTasks, const std::function<void(int, int)>& task);
+
+private:
+	struct Worker
+	{
+		std::thread thread;
+		std::mutex mutex; //guards tasks
+		std::deque<int> tasks;
+	};
+
+	void workerLoop(int worker);
+
+	//next task for worker, its own first, otherwise stolen. False once every deque is empty
+	bool takeTask(int worker, int& index);
+
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	//guards everything below
+	std::mutex mutex;
+	std::condition_variable wake; //a new batch or stopping
+	std::condition_variable done; //pending reached 0
+	const std::function<void(int, int)>* task = nullptr;
+	std::uint64_t batch = 0;
+	int pending = 0;
+	bool stopping = false;
+};
@@ -9,248 +9,18 @@
 #include <chrono>
 #include <numeric>
 #include <fstream>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <memory>
+#include <mutex>
 
 #include "ForestBoard.h"
-
-//Global parameters
-int T = 18250; //730;// 18250;              //Maximum runtime of simulation in days.
-int raking_frequency = 12;                //Raking cycle in days.
-double raking_amount = 0.06;              //Volume of leaf removed at each raking cycle. Value between 0 - 1.
-double nutrient_depletion_rate = 0.001;   //Amount of nutrients depleted from each forest block per day.
-double average_leaf_fall = 0.001;         //Average daily leaf fall.
-double seasonal_leaf_fall_inc = 0.001;    //Seasonal impact on average leaf fall. 0.001, 0.001, 0.005 and 0.000 for spring, summer, fall & winter, respectively.
-double seasonal_leaf_growth_inc = 0.001;  //Seasonal impact on average leaf growth. 0.005, 0.001, 0.000 and 0.000 for spring, summer, fall & winter, respectively.
-double average_leaf_growth = 0.001;       //Average daily leaf growth.
-int average_fire_duration = 5;            //Avergae length of fire.
-int season_length = 91;                   //Length of each season in days.
-double p_fire_neighbor_c = 0.005; //Fixed probability increase of catching fire for each corner neighbor on fire. (4*p_fire_neighbor_c + 4*p_fire_neighbor_e <= 0.5)
-double p_fire_neighbor_e = 0.005; //Fixed probability increase of catching fire for each edge neighbor on fire. (4*p_fire_neighbor_c + 4*p_fire_neighbor_e <= 0.5)
-double p_fire_season = 0;       
-double p_fire_season_base_rate = 0.00001; //Fixed probability increase of catching fire by season. 0.001, 0.002, 0.008, 0.004 for spring, summer, fall & winter, respectively.
-double leaf_fire_contribution = 0.000007; //the amount that the leaf volume contributes to catching on fire
-
-//Utility Parameters
-int rows = 1;                             //Number of rows of forest blocks.
-int cols = 1;                             //Number of cols of forest blocks.
-int season = 0;                           //Current season. 0, 1, 2, 3 for spring, summer, fall & winter, respectively.
-
-//Initialize random number generator
-std::default_random_engine generator;
-std::poisson_distribution<int> fire_duration_generator(average_fire_duration);
-std::uniform_real_distribution<double> uniform_generator(0, 1);
-
-//Utility Matrices
-//Matrices to store indices of corner and edge neighbors. Each matrix stores indices of neighboring nodes in a pair<int, int>, where first = row, second = col.
-std::vector<std::vector<std::vector<std::pair<int, int>>>> Neighbors_c(rows, std::vector<std::vector<std::pair<int, int>>>(cols, std::vector<std::pair<int, int>>()));
-std::vector<std::vector<std::vector<std::pair<int, int>>>> Neighbors_e(rows, std::vector<std::vector<std::pair<int, int>>>(cols, std::vector<std::pair<int, int>>()));
-
-//Function to resize all matrices to current rows x cols values
-void resize_matrices() {
-	//Resize rows
-	Neighbors_c.resize(rows);
-	Neighbors_e.resize(rows);
-
-	//for each row, resize column with default value
-	for (int i = 0; i < rows; ++i) {
-		Neighbors_c[i].resize(cols);
-		Neighbors_e[i].resize(cols);
-	};
-};
-
-//Function to populate Neighbors_c and Neighbors_e matrices
-void update_neighbors() {
-	//Iterate over all forest blocks
-	for (int i = 0; i < rows; ++i) {
-		for (int j = 0; j < cols; ++j) {
-			//Depending on block's location on grid, update corner and edge neighbors
-			if (i > 0 && j > 0) {
-				Neighbors_c[i][j].push_back(std::make_pair(i - 1, j - 1));
-				Neighbors_e[i][j].push_back(std::make_pair(i - 1, j));
-				Neighbors_e[i][j].push_back(std::make_pair(i, j - 1));
-			};
-			if (i < (rows - 1) && j < (cols - 1)) {
-				Neighbors_c[i][j].push_back(std::make_pair(i + 1, j + 1));
-				Neighbors_e[i][j].push_back(std::make_pair(i + 1, j));
-				Neighbors_e[i][j].push_back(std::make_pair(i, j + 1));
-			};
-			if (i < (rows - 1) && j > 0) {
-				Neighbors_c[i][j].push_back(std::make_pair(i + 1, j - 1));
-			};
-			if (i > 0 && j < (cols - 1)) {
-				Neighbors_c[i][j].push_back(std::make_pair(i - 1, j + 1));
-			};
-		};
-	};
-};
-
-//Function to determine if an absorbing state has been reached. Absorbing states: leaf volume of entire forest = 0 or leaf volume of entire forest = MAX.
-bool is_absorbing_state(ForestBoard & board, int trial, int t) {
-	//Variable to track total leaf volume in forest
-	double total_leaf_volume = 0;
-
-	//Iterate over all forest blocks and add leaf volumes
-	for (int i = 0; i < rows; ++i) {
-		for (int j = 0; j < cols; ++j) {
-			total_leaf_volume += board.getForestTile(i, j)->leafVolume;
-		};
-	};
-
-	//If leaf volume == 0 or MAX, return true. (Note: Adjusted by 0.001 to account for c++ rounding errors)
-	if (total_leaf_volume < 0.001) {
-		std::cout << "Reaches absorbing state barren trial : " << trial << " t : " << t << std::endl;
-		return true;
-	}
-	else if (total_leaf_volume > ((rows*cols) - 0.001)) {
-		std::cout << "Reaches absorbing state overgrowth trial : " << trial << " t : " << t << std::endl;
-		return true;
-	}
-	//Else return true
-	else {
-		return false;
-	};
-};
-
-//Daily routine to update raking, nutrients and forest fires (Does not include new forest fire generations).
-void morning_update(int time, ForestBoard & board) {
-	//Checking of raking is required.
-	bool raking_required;
-	if (time > 20 && time % raking_frequency == 0) {
-		raking_required = true;
-	}
-	else {
-		raking_required = false;
-	};
-
-	//Iterate over all forest blocks
-	for (int i = 0; i < rows; ++i) {
-		for (int j = 0; j < cols; ++j) {
-
-			//Raking is required. Rake forest block
-			if (raking_required == true) {
-				//Raking exceeds leaf volume. Rake all leaves
-				if (board.getForestTile(i, j)->leafVolume - raking_amount < 0) {
-					board.getForestTile(i, j)->leafVolume = 0.0;
-				}
-				//Leaf volume exceeds raking. Rake = raking_amount
-				else {
-					board.getForestTile(i, j)->leafVolume = board.getForestTile(i, j)->leafVolume - raking_amount;
-				};
-			};
-
-			//Nutrient depletion exceeds nutrient volume. deplete all nutrients
-			if (board.getForestTile(i, j)->nutrientVolume - nutrient_depletion_rate < 0) {
-				board.getForestTile(i, j)->nutrientVolume = 0.0;
-			}
-			//Nutrient volume exceeds nutrient depletion. Deplete = nutrient_depletion_rate
-			else {
-				board.getForestTile(i, j)->nutrientVolume = board.getForestTile(i, j)->nutrientVolume - nutrient_depletion_rate;
-			};
-
-			//If fire is happening in block, check if scheduled to be done
-			if (board.getForestTile(i, j)->isOnFire == true) {
-				if (board.getForestTile(i, j)->fireEndTime <= time) {
-					board.getForestTile(i, j)->isOnFire = false;
-				};
-			};
-
-			//If fire is scheduled to start as per previous day, update
-			if (board.getForestTile(i, j)->willBeOnFire == true) {
-				//Start fire
-				board.getForestTile(i, j)->isOnFire = true;
-				board.getForestTile(i, j)->willBeOnFire = false;
-				//Convert leaf volume to nutrients. Max value 1.0
-				if (board.getForestTile(i, j)->nutrientVolume + board.getForestTile(i, j)->leafVolume > 1) {
-					board.getForestTile(i, j)->nutrientVolume = 1.0;
-				}
-				else {
-					board.getForestTile(i, j)->nutrientVolume = board.getForestTile(i, j)->nutrientVolume + board.getForestTile(i, j)->leafVolume;
-				};
-				//Set leaf volume to 0.
-				board.getForestTile(i, j)->leafVolume = 0.0;
-			};
-		};
-	};
-};
-
-//Check new fire generations
-void check_new_fire(int time, ForestBoard & board) {
-	//Iterate over all forest blocks
-	for (int i = 0; i < rows; ++i) {
-		for (int j = 0; j < cols; ++j) {
-
-			//Only check if forest block is currently not under fire
-			if (board.getForestTile(i, j)->isOnFire == false) {
-				//Probability constributions from neighboring blocks
-				double p_fire_neighbor = 0.0;
-
-				//Check if corner neighbors are on fire. If yes, increment probability of catching fire
-				for (int k = 0; k < Neighbors_c[i][j].size(); ++k) {
-					int neighbor_i = Neighbors_c[i][j][k].first;
-					int neighbor_j = Neighbors_c[i][j][k].second;
-					if (board.getForestTile(neighbor_i, neighbor_j)->isOnFire == true) {
-						p_fire_neighbor += p_fire_neighbor_c;
-					};
-				};
-
-				//Check if edge neighbors are on fire. If yes, increment probability of catching fire
-				for (int k = 0; k < Neighbors_e[i][j].size(); ++k) {
-					int neighbor_i = Neighbors_e[i][j][k].first;
-					int neighbor_j = Neighbors_e[i][j][k].second;
-					if (board.getForestTile(neighbor_i, neighbor_j)->isOnFire == true) {
-						p_fire_neighbor += p_fire_neighbor_e;
-					};
-				};
-
-				//Calculate probability contribution from leaf volume
-				double p_fire_leaf = board.getForestTile(i, j)->leafVolume * leaf_fire_contribution;
-				//Calculate total probability
-				double p_fire = p_fire_season + p_fire_neighbor + p_fire_leaf;
-
-				//Check if fire will start
-				double rand_var = uniform_generator(generator);
-				if (rand_var < p_fire) {
-					//If fire will start, update to start next day, generate and update duration of fire.
-					board.getForestTile(i, j)->willBeOnFire = true;
-					int t_fire = fire_duration_generator(generator);
-					board.getForestTile(i, j)->fireEndTime = time + t_fire;
-				};
-			};
-		};
-	};
-};
-
-//Update leaves
-void update_leaves(ForestBoard & board) {
-	//Random number generators for leaf fall and leaf growth. Multiply by 1000 to generate integer, then divide by 1000 for double.
-	std::poisson_distribution<int> leaf_fall_generator(1000 * (average_leaf_fall + seasonal_leaf_fall_inc));
-	std::poisson_distribution<int> leaf_growth_generator(1000 * (average_leaf_growth + seasonal_leaf_growth_inc));
-
-	//Iterate over all forest blocks
-	for (int i = 0; i < rows; ++i) {
-		for (int j = 0; j < cols; ++j) {
-			//Only update if forest block is currently not under fire
-			if (board.getForestTile(i, j)->isOnFire == false) {
-				//New leaf fall and growths
-				double new_leaf_fall = (double)leaf_fall_generator(generator) / 1000;
-				double new_leaf_growth = (double)leaf_growth_generator(generator) / 1000;
-				//Change in leaf volume
-				double change_in_leaf = new_leaf_growth + new_leaf_fall;
-				//Update leaf volume in block. Leaf volume exceeds max. Set to 1.
-				if (board.getForestTile(i, j)->leafVolume + change_in_leaf > 1.0) {
-					board.getForestTile(i, j)->leafVolume = 1.0;
-				}
-				//Leaf volume below min. Set to 0.
-				else if (board.getForestTile(i, j)->leafVolume + change_in_leaf < 0.0) {
-					board.getForestTile(i, j)->leafVolume = 0.0;
-				}
-				//Leaf volume between min and max. Update by change_in_leaf.
-				else {
-					board.getForestTile(i, j)->leafVolume = board.getForestTile(i, j)->leafVolume + change_in_leaf;
-				};
-			};
-		};
-	};
-};
+#include "DayKernels.h"
+#include "Simulation.h"
+#include "WorkStealingPool.h"
+#include "TrialSummary.h"
+#include "TrialLanes.h"
 
 //Utility function to print matrix of doubles
 void print_double_matrix(std::vector<std::vector<double>> matrix, int num_rows, int num_cols) {
@@ -282,134 +52,216 @@ void print_int_matrix(std::vector<std::vector<int>> matrix, int num_rows, int nu
 	};
 };
 
-void calculateResults(std::vector<int> & t_vals, std::ofstream & file)
+//Outcome of one trial
+struct TrialResult {
+	int trial;
+	int t;
+	bool absorbing_state;
+};
+
+//Simulation state and finished trials of one worker thread of the trial pool
+struct TrialWorker {
+	SimulationState state;
+	std::unique_ptr<TrialLanes> trial_lanes;  //with --engine=lanes
+	std::vector<TrialResult> results;
+
+	TrialWorker(const SimulationConfig & config) : state(config) {};
+};
+
+//Mean t of the absorbing trials of summary with its 95% confidence interval, from the exact sums so merged shards give the same numbers as one run
+void calculateResults(const TrialSummary & summary, std::ofstream & file)
 {
-	if (t_vals.empty())
+	if (summary.absorbing == 0)
 	{
 		std::cout << "t_vals is empty, nothing to compute" << std::endl;
 		return;
 	}
 
+	double n = double(summary.absorbing);
+
 	//find the sample mean
-	double sample_mean_t_value = double(std::accumulate(t_vals.begin(), t_vals.end(), 0)) / double(t_vals.size());
+	double sample_mean_t_value = double(summary.sum_t) / n;
 
-	//find the sample variance
-	double sampleVariance = 0;
-	for (auto t : t_vals) sampleVariance += pow(t - sample_mean_t_value, 2);
-	sampleVariance = sampleVariance / double(t_vals.size() - 1);
+	//find the sample variance, sum of (t - mean)^2 = sum of t^2 - mean * sum of t
+	double sampleVariance = double(summary.sum_t_squared) - sample_mean_t_value * double(summary.sum_t);
+	sampleVariance = std::max(sampleVariance, 0.0) / (n - 1);
 	sampleVariance = sqrt(sampleVariance);
 
 	//define z for 95% confidence interval
 	double z = 1.96;
 
 	//compute the confidence interval
-	double CI = z * (sampleVariance / sqrt(t_vals.size()));
+	double CI = z * (sampleVariance / sqrt(n));
 
-	printf("The mean t for %d trials with raking freq %d is %f +- %f, \n", numTrials, raking_frequency, sample_mean_t_value, CI);
-	file << "The mean t for " << numTrials << " trials with raking freq " << raking_frequency 
+	printf("The mean t for %lld trials with raking freq %d is %f +- %f, \n", (long long)summary.trials, summary.raking_frequency, sample_mean_t_value, CI);
+	file << "The mean t for " << summary.trials << " trials with raking freq " << summary.raking_frequency 
 		<< " is " << sample_mean_t_value << " +- "  << CI << std::endl;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+
+	//Command line options
+	//--isa=NAME : use the scalar, sse2, avx2 or avx512 day kernels instead of the best ones this CPU supports (for benchmarking)
+	//--seed=N : seed the generator with N instead of the current time
+	//--replay-trial=N : only rerun trial N of the run with that seed (from the seeds file), then stop. No results files are written.
+	//--trace : print the board totals after every day of a replayed trial
+	//--threads=N : run the trials on N threads instead of one per core
+	//--bands=N : run one trial at a time with its board split into N row bands on N threads, for grids too big for one core
+	//--shard=FIRST:COUNT : only run trials FIRST .. FIRST + COUNT - 1 and write their summary to sim_results_freq_F_shard_FIRST.txt.
+	//                      Shards of one sweep need the same --seed (and forest size, raking frequency and --engine), each can run in its own process or on its own machine.
+	//--engine=event : jump over the quiet days between fires from event to event (see run_trial_events), instead of simulating day by day (--engine=day)
+	//--engine=lanes : run TrialLanes::lanes trials side by side on every thread, for boards of up to TrialLanes::maxTiles tiles. Same results as --engine=day
+	//--merge FILE... : merge shard summaries into the mean and confidence interval of the whole sweep, written to sim_results_freq_mean_F.txt
+	const char * requested_isa = nullptr;
+	std::uint64_t seed = std::uint64_t(time(0));
+	int replay_trial = -1;
+	bool trace = false;
+	int num_threads = int(std::thread::hardware_concurrency());
+	int num_bands = 0;
+	int first_trial = 0;
+	int trial_count = numTrials;
+	bool shard = false;
+	bool merge = false;
+	bool event_engine = false;
+	bool lane_engine = false;
+	std::vector<std::string> merge_files;
+	for (int arg = 1; arg < argc; ++arg) {
+		std::string option(argv[arg]);
+		if (option.compare(0, 6, "--isa=") == 0) {
+			requested_isa = argv[arg] + 6;
+		}
+		else if (option.compare(0, 7, "--seed=") == 0) {
+			seed = std::stoull(option.substr(7));
+		}
+		else if (option.compare(0, 15, "--replay-trial=") == 0) {
+			replay_trial = std::stoi(option.substr(15));
+		}
+		else if (option == "--trace") {
+			trace = true;
+		}
+		else if (option.compare(0, 10, "--threads=") == 0) {
+			num_threads = std::stoi(option.substr(10));
+		}
+		else if (option.compare(0, 8, "--bands=") == 0) {
+			num_bands = std::stoi(option.substr(8));
+		}
+		else if (option.compare(0, 8, "--shard=") == 0 && option.find(':') != std::string::npos) {
+			first_trial = std::stoi(option.substr(8));
+			trial_count = std::stoi(option.substr(option.find(':') + 1));
+			shard = true;
+		}
+		else if (option == "--engine=event" || option == "--engine=day" || option == "--engine=lanes") {
+			event_engine = (option == "--engine=event");
+			lane_engine = (option == "--engine=lanes");
+		}
+		else if (option == "--merge") {
+			merge = true;
+		}
+		else if (merge && option.compare(0, 2, "--") != 0) {
+			merge_files.push_back(option);
+		}
+		else {
+			std::cout << "Unknown option " << option << std::endl;
+			return -1;
+		};
+	};
+
+	//Combine the summaries of the shards of a sweep, nothing is simulated
+	if (merge) {
+		std::vector<TrialSummary> shards;
+		for (const std::string & path : merge_files) {
+			TrialSummary shard_summary;
+			if (!read_trial_summary(path, shard_summary)) {
+				return -1;
+			};
+			shards.push_back(shard_summary);
+		};
+
+		TrialSummary merged;
+		if (!merge_trial_summaries(shards, merged)) {
+			return -1;
+		};
+		std::cout << "Merged " << shards.size() << " shards, " << merged.trials << " trials of seed " << merged.seed
+			<< ", t from " << merged.min_t << " to " << merged.max_t << std::endl;
+
+		std::ofstream mean_file(std::string("sim_results_freq_mean_" + std::to_string(merged.raking_frequency) + ".txt").c_str());
+		calculateResults(merged, mean_file);
+		return 0;
+	};
+
+	const DayKernelTable & kernels = select_day_kernels(requested_isa);
+	if (requested_isa && std::string(kernels.name) != requested_isa) {
+		std::cout << "Day kernels " << requested_isa << " are not supported on this CPU" << std::endl;
+	};
+	std::cout << "Using " << kernels.name << " day kernels" << std::endl;
+
+	//Model parameters, the defaults except for the ones asked for
+	SimulationConfig config;
+	config.seed = seed;
+	config.event_engine = event_engine;
 
 	//I/O to retrieve forest size
 	std::cout << "Please enter the number of rows in forest: ";
-	std::cin >> rows;
+	std::cin >> config.rows;
 	std::cout << "Please enter the number of cols in forest: ";
-	std::cin >> cols;
+	std::cin >> config.cols;
 	std::cout << "Please enter the raking frequency: ";
-	std::cin >> raking_frequency;
-
-	//seed the generator
-	generator.seed(time(0));
+	std::cin >> config.raking_frequency;
 
-	//statistics vars
-	std::vector<int> t_values;
+	//fixed point volumes, Poisson samplers and fire thresholds. From here on the configuration is only read
+	prepare_simulation_config(config);
 
-	std::ofstream ofile(std::string("sim_results_freq_" + std::to_string(raking_frequency) + ".txt").c_str());
-	std::ofstream ofile2(std::string("sim_results_freq_mean_" + std::to_string(raking_frequency) + ".txt").c_str());
+#ifdef VISUALIZE
+	//only one board can be drawn
+	num_threads = 1;
+	num_bands = 0;
+	lane_engine = false;
+#endif
 
-	for (int trial = 0; trial < numTrials; trial++)
-	{
-		//init the board
-		ForestBoard board(rows, cols);
+	if (lane_engine && (!TrialLanes::fits(config) || num_bands > 0)) {
+		std::cout << "The lane engine only runs boards of up to " << TrialLanes::maxTiles << " tiles without bands, using the day engine" << std::endl;
+		lane_engine = false;
+	};
+	if (lane_engine && !TrialLanes::isCompiledFor(config)) {
+		std::cout << "No lane engine is compiled for a " << config.rows << " x " << config.cols << " board, using the one for any size" << std::endl;
+	};
 
-		//Resize and update all utility matrices as per rows and cols input
-		resize_matrices();
-		update_neighbors();
+	//With bands the threads work on one trial together
+	std::unique_ptr<WorkStealingPool> band_pool;
+	if (num_bands > 0) {
+		band_pool.reset(new WorkStealingPool(num_bands));
+		num_threads = 1;
+	};
 
-		//Perform simulation untill max simulation time is reached or an absorbing state is reached
+	//Rerun a single trial, e.g. an outlier found in a results file
+	if (replay_trial >= 0) {
+		SimulationState state(config);
 		bool absorbing_state = false;
-		int t = 0;                //Variable to keep track of days.
-		int season_counter = 0;   //Variable to track current season.
-		while (t < T && !absorbing_state) {
-			//Determine current season
-			if (season_counter == season_length) {
-				++season;
-				if (season > 3) {
-					season = 0;
-				}
-				season_counter = 0;
-			}
-
-			//Change seasonal parameters.
-			//Spring
-			if (season == 0) {
-				seasonal_leaf_fall_inc = 0.001;
-				seasonal_leaf_growth_inc = 0.005;
-				p_fire_season = p_fire_season_base_rate * 1;
-			}
-			//Summer
-			else if (season == 1) {
-				seasonal_leaf_fall_inc = 0.001;
-				seasonal_leaf_growth_inc = 0.001;
-				p_fire_season = p_fire_season_base_rate * 2;
-			}
-			//Fall
-			else if (season == 2) {
-				seasonal_leaf_fall_inc = 0.005;
-				seasonal_leaf_growth_inc = 0.000;
-				p_fire_season = p_fire_season_base_rate * 8;
-			}
-			//Winter
-			else if (season == 3) {
-				seasonal_leaf_fall_inc = 0.000;
-				seasonal_leaf_growth_inc = 0.000;
-				p_fire_season = p_fire_season_base_rate * 4;
-			}
-
-			//Update leaf volumes
-			update_leaves(board);
-			//Rake leaves if required, update nutrient depletion and check if fire is scheduled to start/end
-			morning_update(t, board);
-			//Check if new fires will start
-			check_new_fire(t, board);
-			//Check if absorbing states are reached
-			absorbing_state = is_absorbing_state(board, trial, t);
-
-			//TESTING
-				//print_double_matrix(L, rows, cols);
-				//print_bool_matrix(F, rows, cols);
-				//print_bool_matrix(F_nextday, rows, cols);
-				//print_int_matrix(F_endtimes, rows, cols);
-
-			//Increment time counters
-			++t;
-			++season_counter;
+		int t = run_trial(config, state, replay_trial, absorbing_state, trace ? &std::cout : nullptr, band_pool.get());
+		std::cout << "Replayed trial " << replay_trial << " of seed " << seed << " : t = " << t << " Absorbing State? : " << absorbing_state << std::endl;
+		return 0;
+	};
 
-#ifdef VISUALIZE
-			//visualize
-			board.drawBoard();
-			board.display();
-			//std::this_thread::sleep_for(std::chrono::milliseconds(100));
-#endif
-		};
+	//one simulation state (and board) per worker thread, every trial starts from a reset board
+	WorkStealingPool pool(num_threads);
+	std::vector<std::unique_ptr<TrialWorker>> workers;
+	for (int w = 0; w < pool.getNumWorkers(); ++w) {
+		workers.emplace_back(new TrialWorker(config));
+	};
+	if (band_pool) {
+		std::cout << "Running " << trial_count << " trials from trial " << first_trial << " one at a time in " << band_pool->getNumWorkers() << " row bands" << std::endl;
+	}
+	else {
+		std::cout << "Running " << trial_count << " trials from trial " << first_trial << " on " << pool.getNumWorkers() << " threads" << std::endl;
+	};
 
-		//only push if absorbing state
-		if(absorbing_state)
-			t_values.push_back(t);
+	auto trial_ended = [&](TrialWorker & trial_worker, int trial, int t, bool absorbing_state) {
+		trial_worker.results.push_back({ trial, t, absorbing_state });
 
-		std::cout << "Trial Ended : " << trial << " Absorbing State? : " << absorbing_state << std::endl;
+		{
+			std::lock_guard<std::mutex> lock(console_mutex);
+			std::cout << "Trial Ended : " << trial << " Absorbing State? : " << absorbing_state << std::endl;
+		}
 
 #ifdef VISUALIZE
 		if (absorbing_state)
@@ -417,24 +269,78 @@ int main() {
 			std::this_thread::sleep_for(std::chrono::milliseconds(1500));
 		}
 #endif
+	};
 
-#ifdef VISUALIZE
-		//keep the app running
-		//while (1)
-		//{
-		//	board.handleInputEvents();
-		//	//std::this_thread::sleep_for(std::chrono::milliseconds(100));
-		//}
-#endif // VISUALIZE;
+	if (lane_engine) {
+		//a few batches of trials per chunk, so the chunks still spread evenly over the threads
+		int chunk_trials = 4 * TrialLanes::lanes;
+		int chunks = (trial_count + chunk_trials - 1) / chunk_trials;
+		pool.run(chunks, [&](int worker, int chunk) {
+			TrialWorker & trial_worker = *workers[worker];
+			if (!trial_worker.trial_lanes) {
+				trial_worker.trial_lanes = TrialLanes::create(config);
+			};
+
+			int first = first_trial + chunk * chunk_trials;
+			int count = std::min(chunk_trials, first_trial + trial_count - first);
+			trial_worker.trial_lanes->run(first, count, [&](int trial, int t, bool absorbing_state) {
+				trial_ended(trial_worker, trial, t, absorbing_state);
+			});
+		});
 	}
+	else {
+		pool.run(trial_count, [&](int worker, int index) {
+			int trial = first_trial + index;
+
+			//Perform simulation untill max simulation time is reached or an absorbing state is reached
+			bool absorbing_state = false;
+			int t = run_trial(config, workers[worker]->state, trial, absorbing_state, nullptr, band_pool.get());
+			trial_ended(*workers[worker], trial, t, absorbing_state);
+		});
+	};
 
-	//dump results
-	for (auto& elem : t_values)
-		ofile << elem << "\t";
+	//merge the workers' results back into trial order
+	std::vector<TrialResult> results;
+	for (auto & trial_worker : workers) {
+		results.insert(results.end(), trial_worker->results.begin(), trial_worker->results.end());
+	};
+	std::sort(results.begin(), results.end(), [](const TrialResult & a, const TrialResult & b) { return a.trial < b.trial; });
+
+	const char * engine_name = event_engine ? "event" : (lane_engine ? "lanes" : "day");
+	TrialSummary summary = make_trial_summary(config, engine_name, first_trial);
+	for (const TrialResult & result : results) {
+		add_trial(summary, result.t, result.absorbing_state);
+	};
+
+	if (shard) {
+		//only the compact summary, the full statistics come from --merge
+		std::string summary_path = "sim_results_freq_" + std::to_string(config.raking_frequency) + "_shard_" + std::to_string(first_trial) + ".txt";
+		if (!write_trial_summary(summary, summary_path)) {
+			std::cout << "Could not write " << summary_path << std::endl;
+			return -1;
+		};
+		std::cout << "Wrote the summary of trials " << first_trial << " to " << first_trial + trial_count - 1 << " to " << summary_path << std::endl;
+	}
+	else {
+		std::ofstream ofile(std::string("sim_results_freq_" + std::to_string(config.raking_frequency) + ".txt").c_str());
+		std::ofstream ofile2(std::string("sim_results_freq_mean_" + std::to_string(config.raking_frequency) + ".txt").c_str());
 
-	calculateResults(t_values, ofile2);
-	ofile.close();
-	ofile2.close();
+		//Seed and t of every trial, so any of them can be rerun with --seed=SEED --replay-trial=TRIAL
+		std::ofstream seeds_file(std::string("sim_results_freq_seeds_" + std::to_string(config.raking_frequency) + ".txt").c_str());
+		seeds_file << "trial\tseed\tt\tabsorbing" << std::endl;
+
+		for (const TrialResult & result : results) {
+			//dump results, only if absorbing state
+			if (result.absorbing_state)
+				ofile << result.t << "\t";
+
+			seeds_file << result.trial << "\t" << seed << "\t" << result.t << "\t" << result.absorbing_state << std::endl;
+		};
+
+		calculateResults(summary, ofile2);
+		ofile.close();
+		ofile2.close();
+	};
 
 	std::getchar();
 	std::getchar();
@@ -443,4 +349,4 @@ int main() {
 	std::getchar();
 
 	return 0;
-};
\ No newline at end of file
+};